@@ -12,18 +12,181 @@
  *
  */
 
+#define _GNU_SOURCE
+
 #include <assert.h>
+#include <dirent.h>
+#include <dlfcn.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <limits.h>
+#include <link.h>
+#include <malloc.h>
+#include <poll.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <setjmp.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <linux/perf_event.h>
 #include "alloctracker_intern.h"
 
+#ifndef AT_HUGE_PAGE_SIZE
+#define AT_HUGE_PAGE_SIZE ((size_t)2 << 20)
+#endif
+
+#define AT_INDEX_CAPACITY 64
+#define AT_FD_CAPACITY 64
+
+#define AT_SITE_CAPACITY 256
+#define AT_ARENA_CAPACITY 65536
+#define AT_CALLER_CACHE 1024
+#define AT_SCOPE_CAPACITY 64
+
+#ifndef AT_BUDGET_LOG_INTERVAL
+#define AT_BUDGET_LOG_INTERVAL 10
+#endif
+
+#ifndef AT_SCOPE_DEPTH
+#define AT_SCOPE_DEPTH 32
+#endif
+
+#define AT_LOCK() pthread_mutex_lock(&lock)
+#define AT_UNLOCK() pthread_mutex_unlock(&lock)
+
+#ifndef AT_REALLOC_MIN_CALLS
+#define AT_REALLOC_MIN_CALLS 8
+#endif
+
+#ifndef AT_REALLOC_SLOW_GROWTH
+#define AT_REALLOC_SLOW_GROWTH 1.5
+#endif
+
+#ifndef AT_CACHE_LINE
+#define AT_CACHE_LINE 64
+#endif
+
+#ifndef AT_SHARING_SIZE
+#define AT_SHARING_SIZE 128
+#endif
+
+#define AT_LINE_OWNERS 4096
+
+#ifndef AT_IO_TINY_CALLS
+#define AT_IO_TINY_CALLS 64
+#endif
+
+#ifndef AT_IO_TINY_SIZE
+#define AT_IO_TINY_SIZE 64
+#endif
+
+/* the lock is recursive, as tracked functions build upon each other */
+static pthread_mutex_t lock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+static __thread size_t thread_id = 0;
+static __thread at_scope_t *scope_stack[AT_SCOPE_DEPTH];
+static __thread size_t scope_depth = 0;
+static __thread size_t scope_thread_generation = 0;
+static size_t thread_id_counter = 0;
+
 static at_track_stats_t stats;
+static at_map_stats_t map_stats;
+static at_fd_stats_t fd_stats;
+static at_meta_stats_t meta_stats;
+static at_meta_pool_t item_pools[3];
+static at_meta_strings_t string_table = { 0, 0, NULL, NULL };
+static char new_orphans = (char)0;
+static at_fd_table_t fd_table = { 0, 0, NULL };
+static at_site_table_t site_table = { 0, 0, NULL, NULL };
+static at_scope_table_t scope_table = { 0, 0, NULL, NULL };
+static at_budget_t *budgets = NULL;
+static size_t budget_no = 0;
+static at_budget_callback_t budget_callback = NULL;
+static void *budget_data = NULL;
+static size_t scope_generation = 0;
+static at_line_owner_t *line_owners = NULL;
+static at_shm_segment_t *shm_segment = NULL;
+static at_shm_slot_t *shm_slot = NULL;
+static at_track_stats_t shm_base;
+static at_site_t *shm_top[AT_SHM_TOP_SITES];
+static at_sample_ring_t *sampler_ring = NULL;
+static at_track_stats_t sampler_last;
+static pthread_t sampler_thread;
+static pthread_mutex_t sampler_control = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t sampler_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t sampler_wake = PTHREAD_COND_INITIALIZER;
+static char sampler_stopping = (char)0;
+static at_heap_list_item_t *leak_cursor = NULL;
+static uint64_t leak_pass_start = 0;
+static uint64_t leak_prev_start = 0;
+static size_t leak_pass_no = 0;
+static char leak_scanning = (char)0;
+static unsigned int leak_interval = 0;
+static pthread_t leak_thread;
+static pthread_mutex_t leak_control = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t leak_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t leak_wake = PTHREAD_COND_INITIALIZER;
+static char leak_stopping = (char)0;
+static sem_t dump_request;
+static pthread_t dump_thread;
+static char dump_armed = (char)0;
+static char dump_stopping = (char)0;
+static sigset_t dump_signals;
+static struct sigaction dump_previous[NSIG];
+static at_reach_t *reach_state = NULL;
+static int reach_ack[2] = { -1, -1 };
+static uint64_t reach_window = 0;
+static unsigned int reach_resumed = 0;
+static uintptr_t reach_stacks[AT_REACH_TASKS];
+static struct sigaction reach_previous;
+static sem_t reach_ready;
+static sem_t reach_start;
+static pthread_mutex_t reach_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t reach_wake = PTHREAD_COND_INITIALIZER;
+static size_t heap_live_amount = 0;
+static size_t heap_peak_amount = 0;
+static size_t dup_size = 0;
+static size_t unused_size = 0;
+static at_compact_t compact;
+static char compact_enabled = (char)0;
+static at_fault_event_t fault_events[AT_FAULT_EVENTS];
+static size_t fault_event_no = 0;
+static unsigned int fault_period = 0;
+static unsigned int fault_interval = 0;
+static size_t fault_unattributed = 0;
+static size_t fault_lost = 0;
+static pthread_t fault_thread;
+static pthread_mutex_t fault_control = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t fault_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t fault_wake = PTHREAD_COND_INITIALIZER;
+static char fault_stopping = (char)0;
+static size_t class_counts[AT_CLASS_GRANULES];
+static size_t class_amounts[AT_CLASS_GRANULES];
+static size_t class_large_no = 0;
 static at_list_t *heap_list = NULL;
 static at_list_t *file_list = NULL;
+static at_list_t *map_list = NULL;
+static at_arena_t *arena_list = NULL;
+static at_arena_t *arena_orphans = NULL;
+static at_caller_t caller_cache[AT_CALLER_CACHE];
 static size_t heap_id_counter = 0;
 static size_t file_id_counter = 0;
+static size_t map_id_counter = 0;
+static size_t fd_id_counter = 0;
+static size_t arena_id_counter = 0;
 static char can_record = (char)0;
 static char can_report = (char)0;
 
@@ -41,6 +204,91 @@ char *strdup(const char *str)
 }
 #endif
 
+/* the tracker's own bookkeeping (list items, copied strings, indexes and
+   tables) is allocated through the following wrappers, so that its cost
+   can be reported; the blocks handed out to the application are
+   allocated with the plain functions */
+static void at_meta_acquire(void *pointer)
+{
+	size_t held = 0, peak = 0;
+
+	if(!pointer) return;
+	__atomic_add_fetch(&(meta_stats.alloc_no), 1, __ATOMIC_RELAXED);
+	held = __atomic_add_fetch(&(meta_stats.held_amount),
+	                          malloc_usable_size(pointer), __ATOMIC_RELAXED);
+
+	/* a failed exchange reloads "peak", so only a higher peak is kept */
+	peak = __atomic_load_n(&(meta_stats.peak_amount), __ATOMIC_RELAXED);
+	while((held > peak) && !__atomic_compare_exchange_n(&(meta_stats.peak_amount), &peak,
+	                                                    held, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
+
+static void at_meta_release(void *pointer)
+{
+	if(!pointer) return;
+	__atomic_add_fetch(&(meta_stats.free_no), 1, __ATOMIC_RELAXED);
+	__atomic_sub_fetch(&(meta_stats.held_amount),
+	                   malloc_usable_size(pointer), __ATOMIC_RELAXED);
+}
+
+static void *at_meta_malloc(size_t length)
+{
+	void *pointer = malloc(length);
+	at_meta_acquire(pointer);
+	return pointer;
+}
+
+static void *at_meta_calloc(size_t blocks, size_t length)
+{
+	void *pointer = calloc(blocks, length);
+	at_meta_acquire(pointer);
+	return pointer;
+}
+
+static void *at_meta_realloc(void *pointer, size_t length)
+{
+	size_t usable = (pointer ? malloc_usable_size(pointer) : 0);
+	void *grown = realloc(pointer, length);
+
+	if(!grown) return NULL;
+	if(pointer)
+	{
+		__atomic_add_fetch(&(meta_stats.free_no), 1, __ATOMIC_RELAXED);
+		__atomic_sub_fetch(&(meta_stats.held_amount), usable, __ATOMIC_RELAXED);
+	}
+	at_meta_acquire(grown);
+	return grown;
+}
+
+static void at_meta_free(void *pointer)
+{
+	at_meta_release(pointer);
+	free(pointer);
+}
+
+static char *at_meta_strdup(const char *str)
+{
+	char *dup = strdup(str);
+	at_meta_acquire(dup);
+	return dup;
+}
+
+#define at_meta_free_null(p) if(p) { at_meta_free(p); p = NULL; }
+
+static uint64_t at_meta_clock(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (((uint64_t)now.tv_sec * 1000000000) + (uint64_t)now.tv_nsec);
+}
+
+static void at_meta_time(at_meta_timer_t *timer, uint64_t start)
+{
+	__atomic_add_fetch(&(timer->time), (at_meta_clock() - start), __ATOMIC_RELAXED);
+	__atomic_add_fetch(&(timer->call_no), 1, __ATOMIC_RELAXED);
+}
+
 static const char *at_basename(const char *filename)
 {
 	if(!filename || !strlen(filename)) return "";
@@ -51,11 +299,10 @@ char *at_truncate_back(const char *str, int len)
 {
 	char *trunc = NULL;
 
-	if(!str || !strlen(str)) return strdup("");
-	if((len < 0) || (strlen(str) <= (unsigned int)len)) return strdup(str);
+	if(!str || !strlen(str)) return at_meta_strdup("");
+	if((len < 0) || (strlen(str) <= (unsigned int)len)) return at_meta_strdup(str);
 
-	trunc = (char *)malloc((len + 1) * sizeof(char));
-	trunc = strdup(str);
+	trunc = at_meta_strdup(str);
 	strcpy(&trunc[(len - 3)], "...");
 	trunc[len] = '\0';
 	return trunc;
@@ -65,666 +312,6091 @@ char *at_truncate_front(const char *str, int len)
 {
 	char *trunc = NULL;
 
-	if(!str || !strlen(str)) return strdup("");
-	if((len < 0) || (strlen(str) <= (unsigned int)len)) return strdup(str);
+	if(!str || !strlen(str)) return at_meta_strdup("");
+	if((len < 0) || (strlen(str) <= (unsigned int)len)) return at_meta_strdup(str);
 
-	trunc = (char *)malloc((len + 1) * sizeof(char));
+	trunc = (char *)at_meta_malloc((len + 1) * sizeof(char));
 	strcpy(trunc, "...");
 	strcat(trunc, &str[(strlen(str) - len + 3)]);
 	return trunc;
 }
 
-static void at_track_stats_init(void)
+/* threads are numbered in the order they first call the tracker */
+static size_t at_thread_self(void)
 {
-	if(can_record) return;
-	memset(&stats, '\0', sizeof(at_track_stats_t));
-	can_record = (char)1;
+	if(!thread_id) thread_id = __atomic_add_fetch(&thread_id_counter, 1, __ATOMIC_RELAXED);
+	return thread_id;
+}
 
-	if(!can_report)
-	{
-		if((heap_list && heap_list->length) ||
-		   (file_list && file_list->length))
-			 can_report = (char)1;
-	 }
+/* mixes the bits of an address (or any integer key) into a slot of a
+   table of "capacity" slots, a power of two; used by the list index and
+   the table of cache line owners */
+static size_t at_index_hash(const void *key, size_t capacity)
+{
+	uint64_t hash = (uint64_t)(uintptr_t)key;
+
+	hash ^= (hash >> 33);
+	hash *= 0xff51afd7ed558ccdULL;
+	hash ^= (hash >> 33);
+	return ((size_t)hash & (capacity - 1));
 }
 
-static void at_track_stats_aquire(at_list_item_t *item, at_list_type_t type)
+static size_t at_site_hash(const char *filename, const char *function, int line)
 {
-	at_heap_list_item_t *heap_item = NULL;
+	size_t hash = (size_t)2166136261UL;
 
-	if(!item) return;
-	if(!can_record) at_track_stats_init();
+	/* FNV-1a over both strings and the line number */
+	while(filename && *filename) hash = ((hash ^ (unsigned char)(*(filename++))) * 16777619UL);
+	while(function && *function) hash = ((hash ^ (unsigned char)(*(function++))) * 16777619UL);
+	return ((hash ^ (size_t)line) * 16777619UL);
+}
 
-	if(type == AT_LIST_TYPE_HEAP)
-	{
-		heap_item = (at_heap_list_item_t *)item;
-		stats.alloc_amount += heap_item->size;
-		++(stats.alloc_no);
-	}
-	else if(type == AT_LIST_TYPE_FILE) ++(stats.open_no);
+static char at_site_match(at_site_t *site, const char *filename,
+	const char *function, int line)
+{
+	if(site->line != line) return (char)0;
+	if((!site->filename != !filename) || (!site->function != !function)) return (char)0;
+	if(filename && strcmp(site->filename, filename)) return (char)0;
+	if(function && strcmp(site->function, function)) return (char)0;
+	return (char)1;
 }
 
-static void at_track_stats_release(at_list_item_t *item, at_list_type_t type)
+static void at_site_table_grow(void)
 {
-	at_heap_list_item_t *heap_item = NULL;
+	at_site_t **buckets = NULL, **sites = NULL, *site = NULL;
+	size_t capacity = (site_table.capacity ? (site_table.capacity * 2) : AT_SITE_CAPACITY);
+	size_t i = 0, bucket = 0;
 
-	if(!item) return;
-	if(!can_record) at_track_stats_init();
+	buckets = (at_site_t **)at_meta_calloc(capacity, sizeof(at_site_t *));
+	sites = (at_site_t **)at_meta_realloc(site_table.sites, (capacity * sizeof(at_site_t *)));
 
-	if(type == AT_LIST_TYPE_HEAP)
+	if(!buckets || !sites)
 	{
-		heap_item = (at_heap_list_item_t *)item;
-		stats.free_amount += heap_item->size;
-		++(stats.free_no);
+		at_meta_free_null(buckets);
+		if(sites) site_table.sites = sites;
+		return;
 	}
-	else if(type == AT_LIST_TYPE_FILE) ++(stats.close_no);
+
+	for(i = 0; i < site_table.length; i++)
+	{
+		site = sites[i];
+		bucket = (at_site_hash(site->filename, site->function, site->line) & (capacity - 1));
+		site->next = buckets[bucket];
+		buckets[bucket] = site;
+	}
+
+	at_meta_free_null(site_table.buckets);
+	site_table.buckets = buckets;
+	site_table.sites = sites;
+	site_table.capacity = capacity;
 }
 
-at_heap_list_item_t *at_heap_list_item_new(const char *filename, const char *function, int line)
+/* the budget of a site is armed as the one threshold ("budget_limit")
+   its live bytes are compared against on every allocation; once the live
+   bytes drop below "budget_rearm" again, the lower threshold is re-armed */
+static void at_budget_arm(at_site_t *site)
 {
-	at_heap_list_item_t *item = NULL;
+	size_t low = (site->budget_soft ? site->budget_soft : site->budget_hard);
 
-	item = (at_heap_list_item_t *)malloc(sizeof(at_heap_list_item_t));
+	site->budget_limit = SIZE_MAX;
+	site->budget_rearm = 0;
 
-	if(filename)
-	{
-		item->filename = (char *)malloc((strlen(filename) + 1) * sizeof(char));
-		strcpy(item->filename, (char *)filename);
-	}
-	else item->filename = NULL;
+	if(site->budget_soft && (site->live_amount <= site->budget_soft))
+		site->budget_limit = site->budget_soft;
+	else if(site->budget_hard && (site->live_amount <= site->budget_hard))
+		site->budget_limit = site->budget_hard;
 
-	if(function)
+	if(low && (site->budget_limit != low)) site->budget_rearm = low;
+}
+
+static char at_budget_match(at_budget_t *budget, at_site_t *site)
+{
+	char location[FILENAME_MAX + 16];
+
+	snprintf(location, sizeof(location), "%s:%d", at_basename(site->filename), site->line);
+
+	return (char)(!fnmatch(budget->pattern, at_basename(site->filename), 0) ||
+	              !fnmatch(budget->pattern, location, 0) ||
+	              (site->function && !fnmatch(budget->pattern, site->function, 0)));
+}
+
+/* the most recently set matching budget applies to a site */
+static void at_budget_apply(at_site_t *site)
+{
+	size_t i = budget_no;
+
+	site->budget_soft = site->budget_hard = 0;
+
+	while(i--)
 	{
-		item->function = (char *)malloc((strlen(function) + 1) * sizeof(char));
-		strcpy(item->function, (char *)function);
+		if(!at_budget_match(&(budgets[i]), site)) continue;
+		site->budget_soft = budgets[i].soft;
+		site->budget_hard = budgets[i].hard;
+		break;
 	}
-	else item->function = NULL;
 
-	item->line = line;
-	item->id = (heap_id_counter++);
-	item->prev = item->next = NULL;
-	item->pointer = NULL;
-	item->size = 0;
-	return item;
+	at_budget_arm(site);
 }
 
-at_file_list_item_t *at_file_list_item_new(const char *filename, const char *function, int line)
+/* every distinct source code location owns one site record, which
+   accumulates statistics beyond the lifetime of single allocations */
+at_site_t *at_site_get(const char *filename, const char *function, int line)
 {
-	at_file_list_item_t *item = NULL;
+	at_site_t *site = NULL;
+	size_t hash = at_site_hash(filename, function, line);
+
+	if(site_table.capacity)
+	{
+		site = site_table.buckets[(hash & (site_table.capacity - 1))];
+
+		while(site && !at_site_match(site, filename, function, line))
+			site = site->next;
 
-	item = (at_file_list_item_t *)malloc(sizeof(at_file_list_item_t));
+		if(site) return site;
+	}
+
+	if(site_table.length >= site_table.capacity) at_site_table_grow();
+	if(site_table.length >= site_table.capacity) return NULL;
+
+	site = (at_site_t *)at_meta_calloc(1, sizeof(at_site_t));
+	if(!site) return NULL;
 
 	if(filename)
 	{
-		item->filename = (char *)malloc((strlen(filename) + 1) * sizeof(char));
-		strcpy(item->filename, (char *)filename);
+		site->filename = (char *)at_meta_malloc((strlen(filename) + 1) * sizeof(char));
+		strcpy(site->filename, filename);
 	}
-	else item->filename = NULL;
 
 	if(function)
 	{
-		item->function = (char *)malloc((strlen(function) + 1) * sizeof(char));
-		strcpy(item->function, (char *)function);
+		site->function = (char *)at_meta_malloc((strlen(function) + 1) * sizeof(char));
+		strcpy(site->function, function);
 	}
-	else item->function = NULL;
 
-	item->line = line;
-	item->id = (file_id_counter++);
-	item->prev = item->next = NULL;
-	item->handle = NULL;
-	item->name = NULL;
-	item->mode = NULL;
-	return item;
+	site->line = line;
+	at_budget_apply(site);
+	site->id = (site_table.length + 1);
+	site->next = site_table.buckets[(hash & (site_table.capacity - 1))];
+	site_table.buckets[(hash & (site_table.capacity - 1))] = site;
+	site_table.sites[(site_table.length++)] = site;
+	return site;
 }
 
-void at_list_add(at_list_t *list, at_list_item_t *item, at_list_type_t type)
+static void at_site_table_free(void)
 {
-	at_list_item_t *tmp = NULL;
+	size_t i = 0;
 
-	if(!item) return;
+	for(i = 0; i < site_table.length; i++)
+	{
+		at_meta_free_null(site_table.sites[i]->filename);
+		at_meta_free_null(site_table.sites[i]->function);
+		at_meta_free_null(site_table.sites[i]);
+	}
 
-	if(!list)
+	at_meta_free_null(site_table.sites);
+	at_meta_free_null(site_table.buckets);
+	site_table.capacity = site_table.length = 0;
+}
+
+static void at_scope_table_grow(void)
+{
+	at_scope_t **buckets = NULL, **scopes = NULL, *scope = NULL;
+	size_t capacity = (scope_table.capacity ? (scope_table.capacity * 2) : AT_SCOPE_CAPACITY);
+	size_t i = 0, bucket = 0;
+
+	buckets = (at_scope_t **)at_meta_calloc(capacity, sizeof(at_scope_t *));
+	scopes = (at_scope_t **)at_meta_realloc(scope_table.scopes, (capacity * sizeof(at_scope_t *)));
+
+	if(!buckets || !scopes)
 	{
-		list = (at_list_t *)malloc(sizeof(at_list_t));
-		list->first = list->last = item;
-		list->length = 1;
-		list->type = type;
+		at_meta_free_null(buckets);
+		if(scopes) scope_table.scopes = scopes;
+		return;
 	}
-	else
+
+	for(i = 0; i < scope_table.length; i++)
 	{
-		if(!(list->length))
-		{
-			list->first = list->last = item;
-			list->length = 1;
-		}
-		else
-		{
-			tmp = list->last;
-			item->prev = tmp;
-			tmp->next = item;
-			list->last = item;
-			++(list->length);
-		}
+		scope = scopes[i];
+		bucket = (at_site_hash(scope->tag, NULL, 0) & (capacity - 1));
+		scope->next = buckets[bucket];
+		buckets[bucket] = scope;
 	}
 
-	if((type == AT_LIST_TYPE_HEAP) && !heap_list) heap_list = list;
-	if((type == AT_LIST_TYPE_FILE) && !file_list) file_list = list;
+	at_meta_free_null(scope_table.buckets);
+	scope_table.buckets = buckets;
+	scope_table.scopes = scopes;
+	scope_table.capacity = capacity;
+}
 
-	at_track_stats_aquire(item, type);
-	can_report = (char)1;
+static at_scope_t *at_scope_find(const char *tag)
+{
+	at_scope_t *scope = NULL;
+
+	if(!scope_table.capacity) return NULL;
+	scope = scope_table.buckets[(at_site_hash(tag, NULL, 0) & (scope_table.capacity - 1))];
+	while(scope && strcmp(scope->tag, tag)) scope = scope->next;
+	return scope;
 }
 
-at_list_item_t *at_list_get(at_list_t *list, void *pointer)
+/* every distinct tag owns one scope record, like a call site */
+static at_scope_t *at_scope_get(const char *tag)
 {
-	at_list_item_t *item = NULL;
+	at_scope_t *scope = at_scope_find(tag);
+	size_t bucket = 0;
 
-	if(!pointer || !list) return NULL;
-	if(!(list->length)) return NULL;
+	if(scope) return scope;
 
-	item = list->first;
+	if(scope_table.length >= scope_table.capacity) at_scope_table_grow();
+	if(scope_table.length >= scope_table.capacity) return NULL;
 
-	while(item)
+	scope = (at_scope_t *)at_meta_calloc(1, sizeof(at_scope_t));
+	if(!scope) return NULL;
+
+	scope->tag = (char *)at_meta_malloc((strlen(tag) + 1) * sizeof(char));
+
+	if(!(scope->tag))
 	{
-		if(((list->type == AT_LIST_TYPE_HEAP) &&
-		    (((at_heap_list_item_t *)item)->pointer == pointer)) ||
-		   ((list->type == AT_LIST_TYPE_FILE) &&
-		    (((at_file_list_item_t *)item)->handle == (FILE *)pointer)))
-			 return item;
-		item = item->next;
+		at_meta_free(scope);
+		return NULL;
 	}
 
-	return NULL;
+	strcpy(scope->tag, tag);
+	bucket = (at_site_hash(tag, NULL, 0) & (scope_table.capacity - 1));
+	scope->id = (scope_table.length + 1);
+	scope->next = scope_table.buckets[bucket];
+	scope_table.buckets[bucket] = scope;
+	scope_table.scopes[(scope_table.length++)] = scope;
+	return scope;
 }
 
-void at_list_remove(at_list_t *list, void *pointer)
+static void at_scope_table_free(void)
 {
-	at_list_item_t *item = NULL;
+	size_t i = 0;
 
-	if(!pointer || !list) return;
-	if(!(list->length)) return;
+	for(i = 0; i < scope_table.length; i++)
+	{
+		at_meta_free_null(scope_table.scopes[i]->tag);
+		at_meta_free_null(scope_table.scopes[i]);
+	}
 
-	if((item = at_list_get(list, pointer)))
+	at_meta_free_null(scope_table.scopes);
+	at_meta_free_null(scope_table.buckets);
+	scope_table.capacity = scope_table.length = 0;
+
+	/* stacks of other threads may still refer to the freed scopes */
+	++scope_generation;
+}
+
+/* the innermost scope of the calling thread; pushes beyond
+   AT_SCOPE_DEPTH are charged to the deepest recorded scope */
+static at_scope_t *at_scope_current(void)
+{
+	if(scope_thread_generation != scope_generation)
 	{
-		if(item->prev) item->prev->next = item->next;
-		else list->first = item->next;
-		at_track_stats_release(item, list->type);
-		at_list_free_item(&item, list->type);
-		--(list->length);
+		memset(scope_stack, '\0', sizeof(scope_stack));
+		scope_thread_generation = scope_generation;
 	}
 
-	return;
+	if(!scope_depth) return NULL;
+	return scope_stack[(((scope_depth < AT_SCOPE_DEPTH) ? scope_depth : AT_SCOPE_DEPTH) - 1)];
 }
 
-void at_list_free_item(at_list_item_t **item, at_list_type_t type)
+static void at_scope_acquire(at_scope_t *scope, size_t size)
 {
-	at_heap_list_item_t **heap_item = NULL;
-	at_file_list_item_t **file_item = NULL;
+	if(!scope) return;
+	++(scope->alloc_no);
+	scope->alloc_amount += size;
+	++(scope->live_no);
+	scope->live_amount += size;
+	if(scope->live_amount > scope->peak_amount) scope->peak_amount = scope->live_amount;
+}
 
-	if(!item) return;
-	if(!(*item)) return;
+static void at_scope_release(at_scope_t *scope, size_t size)
+{
+	if(!scope) return;
+	++(scope->free_no);
+	--(scope->live_no);
+	scope->live_amount -= size;
+}
 
-	if(type == AT_LIST_TYPE_HEAP)
-	{
-		heap_item = (at_heap_list_item_t **)item;
+void at_scope_push(const char *tag)
+{
+	if(!tag) return;
+	AT_LOCK();
+	at_scope_current();
+	if(scope_depth < AT_SCOPE_DEPTH) scope_stack[scope_depth] = at_scope_get(tag);
+	++scope_depth;
+	AT_UNLOCK();
+}
 
-		if(((signed long)(*heap_item)->size) <= 0)
-		{
-			fprintf(stderr,
-				"[heap] invalid allocation size of %ld bytes detected\n",
-				((signed long)((*heap_item)->size)));
-		}
-		else at_free_null((*heap_item)->pointer);
-	}
-	else if(type == AT_LIST_TYPE_FILE)
+void at_scope_pop(void)
+{
+	if(scope_depth) --scope_depth;
+}
+
+int at_scope_query(const char *tag, at_scope_stats_t *scope_stats)
+{
+	at_scope_t *scope = NULL;
+
+	if(!tag || !scope_stats) return -1;
+	AT_LOCK();
+
+	if(!(scope = at_scope_find(tag)))
 	{
-		file_item = (at_file_list_item_t **)item;
-		if(((*file_item)->handle)) fclose((*file_item)->handle);
-		at_free_null((*file_item)->name);
-		at_free_null((*file_item)->mode);
+		AT_UNLOCK();
+		return -1;
 	}
 
-	at_free_null((*item)->filename);
-	at_free_null((*item)->function);
-	at_free_null((*item));
+	scope_stats->alloc_amount = scope->alloc_amount;
+	scope_stats->alloc_no = scope->alloc_no;
+	scope_stats->free_no = scope->free_no;
+	scope_stats->live_amount = scope->live_amount;
+	scope_stats->peak_amount = scope->peak_amount;
+	AT_UNLOCK();
+	return 0;
+}
+
+int at_stats_query(at_stats_t *track_stats)
+{
+	if(!track_stats) return -1;
+	AT_LOCK();
+	track_stats->alloc_no = stats.alloc_no;
+	track_stats->free_no = stats.free_no;
+	track_stats->live_no = (at_list_length(heap_list) + compact.live);
+	track_stats->live_amount = heap_live_amount;
+	track_stats->map_no = at_list_length(map_list);
+	track_stats->map_amount = (map_stats.map_amount - map_stats.unmap_amount);
+	track_stats->fd_no = fd_table.length;
+	track_stats->fd_open_no = fd_stats.open_no;
+	track_stats->fd_close_no = fd_stats.close_no;
+	track_stats->mismatch_no = stats.mismatch_no;
+	track_stats->untracked_no = stats.untracked_no;
+	track_stats->meta_alloc_no = __atomic_load_n(&(meta_stats.alloc_no), __ATOMIC_RELAXED);
+	track_stats->meta_held_amount = __atomic_load_n(&(meta_stats.held_amount), __ATOMIC_RELAXED);
+	track_stats->timed_alloc_no = (size_t)__atomic_load_n(&(meta_stats.alloc.call_no), __ATOMIC_RELAXED);
+	track_stats->timed_free_no = (size_t)__atomic_load_n(&(meta_stats.free.call_no), __ATOMIC_RELAXED);
+	track_stats->compact_no = compact.live;
+	track_stats->squeeze_no = compact.squeeze_no;
+	AT_UNLOCK();
+	return 0;
 }
 
-void at_list_free(at_list_t *list)
+/* the first call site at the line of the file, as named by its base name */
+int at_site_query(const char *filename, int line, at_site_stats_t *site_stats)
 {
-	at_list_item_t *item = NULL, *tmp = NULL;
+	at_site_t *site = NULL;
+	size_t i = 0;
 
-	if(!list) return;
+	if(!filename || !site_stats) return -1;
+	AT_LOCK();
 
-	if((list->length))
+	for(i = 0; i < site_table.length; i++)
 	{
-		item = list->first;
+		site = site_table.sites[i];
 
-		while(item)
-		{
-			tmp = item->next;
-			at_list_free_item(&item, list->type);
-			item = tmp;
-		}
+		if((site->line == line) && site->filename &&
+		   !strcmp(at_basename(site->filename), at_basename(filename)))
+			break;
+	}
+
+	if(i == site_table.length)
+	{
+		AT_UNLOCK();
+		return -1;
 	}
 
-	at_free_null(list);
+	site_stats->alloc_no = site->alloc_no;
+	site_stats->free_no = site->free_no;
+	site_stats->live_no = site->live_no;
+	site_stats->live_amount = site->live_amount;
+	site_stats->realloc_no = site->realloc_no;
+	site_stats->remote_free_no = site->remote_free_no;
+	site_stats->remote_realloc_no = site->remote_realloc_no;
+	site_stats->reach_no = site->reach_no;
+	site_stats->reach_amount = site->reach_amount;
+	site_stats->dup_no = site->dup_no;
+	site_stats->dup_amount = site->dup_amount;
+	site_stats->fault_minor = site->fault_minor;
+	site_stats->fault_major = site->fault_major;
+	site_stats->fault_touched = site->fault_touched;
+	site_stats->unused_no = site->unused_no;
+	site_stats->unused_reserved = site->unused_reserved;
+	site_stats->unused_used = site->unused_used;
+	AT_UNLOCK();
+	return 0;
 }
 
-size_t at_list_length(at_list_t *list)
+static size_t at_heap_item_size(at_heap_list_item_t *item)
 {
-	if(!list) return (size_t)0;
-	return list->length;
+	return ((item->size > 0) ? (size_t)(item->size) : 0);
 }
 
-void at_free_all(void)
+static const char *at_alloc_kind_name(at_alloc_kind_t kind, char release)
 {
-	at_list_free(heap_list);
-	at_list_free(file_list);
-	can_report = (char)0;
+	if(kind == AT_ALLOC_KIND_NEW) return (release ? "delete" : "new");
+	if(kind == AT_ALLOC_KIND_NEW_ARRAY) return (release ? "delete[]" : "new[]");
+	return (release ? "free" : "malloc");
 }
 
-void at_report(void)
+static void at_heap_item_mismatch(at_heap_list_item_t *item, at_alloc_kind_t kind)
 {
-	at_heap_list_item_t *heap_item = NULL;
-	at_file_list_item_t *file_item = NULL;
-	size_t leaksum = 0, leaks = 0, open = 0;
-	char *file = NULL, *source = NULL, *func = NULL;
+	++(stats.mismatch_no);
+	fprintf(stderr,
+		"[heap] block of %ld bytes allocated with \"%s\" at %s:%d released with \"%s\"\n",
+		item->size, at_alloc_kind_name(item->kind, (char)0), at_basename(item->filename),
+		item->line, at_alloc_kind_name(kind, (char)1));
+}
 
-	if(!can_report) return;
-	if(!heap_list && !file_list) return;
-	if(!(heap_list->length) && !(file_list->length)) return;
+static void at_budget_exceeded(at_site_t *site)
+{
+	size_t budget = site->budget_soft;
+	int hard = 0;
+	long now = (long)time(NULL);
 
-	fprintf(stderr, "\nALLOC TRACKER REPORT:\n\n");
+	if(site->budget_hard && (site->live_amount > site->budget_hard))
+	{
+		budget = site->budget_hard;
+		hard = 1;
+	}
+
+	at_budget_arm(site);
 
-	if(heap_list && (heap_list->length))
+	if(budget_callback)
 	{
-		heap_item = (at_heap_list_item_t *)(heap_list->first);
+		budget_callback(site->filename, site->function, site->line,
+			site->live_amount, budget, hard, budget_data);
+		return;
+	}
 
-		if(heap_item) fprintf(stderr, "unfreed memory:\n");
+	/* a site flapping around its soft budget is only logged once in a while */
+	if(!hard && site->budget_logged && ((now - site->budget_logged) < AT_BUDGET_LOG_INTERVAL))
+		return;
 
-		while(heap_item)
-		{
-			leaksum += heap_item->size;
-			++leaks;
+	site->budget_logged = now;
 
-			source = at_truncate(at_basename(heap_item->filename), 20);
-			func = at_truncate(heap_item->function, 20);
+	fprintf(stderr, "[budget] %s budget of %lu bytes exceeded by %s:%d %s%s (%lu bytes live)\n",
+		(hard ? "hard" : "soft"), (unsigned long)budget, at_basename(site->filename),
+		site->line, (site->function ? site->function : ""), (site->function ? "()" : ""),
+		(unsigned long)(site->live_amount));
+}
 
-			fprintf(stderr,
-				"  %-18p  %6ld B  %20s:%-4d  %s%s\n", heap_item->pointer,
-				heap_item->size, source, heap_item->line, func,
-				(strlen(func) ? "()" : ""));
+int at_budget_set(const char *pattern, size_t soft, size_t hard)
+{
+	at_budget_t *grown = NULL;
+	size_t i = 0;
 
-			heap_item = heap_item->next;
-			at_free_null(source);
-			at_free_null(func);
-		}
+	if(!pattern || !strlen(pattern)) return -1;
+	AT_LOCK();
 
-		fprintf(stderr,
-			"\n  overall %lu byte%s in %lu block%s unfreed\n\n",
-			leaksum, ((leaksum == 1) ? "" : "s"), leaks,
-			((leaks == 1) ? "" : "s"));
-	}
+	for(i = 0; i < budget_no; i++)
+		if(!strcmp(budgets[i].pattern, pattern)) break;
 
-	if(file_list && (file_list->length))
+	if(i == budget_no)
 	{
-		file_item = (at_file_list_item_t *)(file_list->first);
-
-		if(file_item) fprintf(stderr, "unclosed files:\n");
+		grown = (at_budget_t *)at_meta_realloc(budgets, ((budget_no + 1) * sizeof(at_budget_t)));
 
-		while(file_item)
+		if(!grown)
 		{
-			++open;
-			file = at_truncate(at_basename(file_item->name), 20);
-			source = at_truncate(at_basename(file_item->filename), 20);
-			func = at_truncate(file_item->function, 20);
+			AT_UNLOCK();
+			return -1;
+		}
 
-			fprintf(stderr,
-				"  %-18p  %-20s  %-3s  %20s:%-4d  %s%s\n", (void *)(file_item->handle),
-				file, file_item->mode, source, file_item->line, func,
-				(strlen(func) ? "()" : ""));
+		budgets = grown;
+		budgets[i].pattern = (char *)at_meta_malloc((strlen(pattern) + 1) * sizeof(char));
 
-			file_item = file_item->next;
-			at_free_null(file);
-			at_free_null(source);
-			at_free_null(func);
+		if(!(budgets[i].pattern))
+		{
+			AT_UNLOCK();
+			return -1;
 		}
 
-		fprintf(stderr,
-			"\n  overall %lu file%s unclosed\n\n",
-			open, ((open == 1) ? "" : "s"));
+		strcpy(budgets[i].pattern, pattern);
+		++budget_no;
 	}
 
-	if(!can_record) return;
+	budgets[i].soft = soft;
+	budgets[i].hard = hard;
 
-	fprintf(stderr, "system resource summary:\n");
-	fprintf(stderr, "  heap space allocated:  %lu bytes\n", stats.alloc_amount);
-	fprintf(stderr, "  heap space freed:      %lu bytes\n", stats.free_amount);
-	fprintf(stderr, "  allocations:           %lu\n", stats.alloc_no);
-	fprintf(stderr, "  frees:                 %lu\n", stats.free_no);
-	fprintf(stderr, "  files opened:          %lu\n", stats.open_no);
-	fprintf(stderr, "  files closed:          %lu\n", stats.close_no);
-	fprintf(stderr, "\n\n");
+	for(i = 0; i < site_table.length; i++) at_budget_apply(site_table.sites[i]);
+
+	AT_UNLOCK();
+	return 0;
 }
 
-void *at_malloc(size_t length, const char *filename,
-	const char *function, int line)
+/* the callback is invoked with the tracker locked, in the thread whose
+   allocation exceeds the budget */
+void at_budget_callback(at_budget_callback_t callback, void *data)
 {
-	at_heap_list_item_t *item = NULL;
+	AT_LOCK();
+	budget_callback = callback;
+	budget_data = data;
+	AT_UNLOCK();
+}
 
-	if(!length || (((signed long)length) < 0))
-	{
-		fprintf(stderr,
-			"[heap] invalid allocation request for %ld bytes detected\n",
-			((signed long)length));
-		return NULL;
-	}
+static void at_budget_free(void)
+{
+	size_t i = 0;
 
-	item = at_heap_list_item_new(filename, function, line);
-	item->pointer = (void *)malloc(length);
-	if(item->pointer) item->size = length;
-	else item->size = (long)(-1);
-	at_list_add(heap_list, (at_list_item_t *)item, AT_LIST_TYPE_HEAP);
-	return item->pointer;
+	for(i = 0; i < budget_no; i++) at_meta_free_null(budgets[i].pattern);
+	at_meta_free_null(budgets);
+	budget_no = 0;
 }
 
-void *at_calloc(size_t blocks, size_t length, const char *filename,
-	const char *function, int line)
+/* every increase of the live bytes, whether by a new block or by a
+   block growing in place of its origin, is checked against the budget */
+static void at_site_grow(at_site_t *site, size_t size)
 {
-	at_heap_list_item_t *item = NULL;
+	heap_live_amount += size;
+	if(heap_live_amount > heap_peak_amount) heap_peak_amount = heap_live_amount;
 
-	if(!blocks || !length ||
-		 (((signed long)blocks) < 0) ||
-	   (((signed long)length) < 0))
+	if(!site) return;
+	site->live_amount += size;
+	if(site->live_amount > site->peak_amount) site->peak_amount = site->live_amount;
+	if(site->live_amount > site->budget_limit) at_budget_exceeded(site);
+}
+
+static void at_site_acquire(at_site_t *site, size_t size)
+{
+	if(site)
 	{
-		fprintf(stderr,
-			"[heap] invalid allocation request for %ld bytes detected\n",
-			(((signed long)blocks) * ((signed long)length)));
-		return NULL;
+		++(site->live_no);
+		if(site->live_no > site->peak_no) site->peak_no = site->live_no;
 	}
 
-	item = at_heap_list_item_new(filename, function, line);
-	item->pointer = (void *)calloc(blocks, length);
-	if(item->pointer) item->size = (blocks * length);
-	else item->size = (long)(-1);
-	at_list_add(heap_list, (at_list_item_t *)item, AT_LIST_TYPE_HEAP);
-	return item->pointer;
+	at_site_grow(site, size);
 }
 
-void *at_realloc(void *ptr, size_t length, const char *filename,
-	const char *function, int line)
+static void at_site_release(at_site_t *site, size_t size)
 {
-	at_heap_list_item_t *item = NULL;
+	heap_live_amount -= size;
+	if(!site) return;
+	--(site->live_no);
+	if(site->live_no < site->leak_low) site->leak_low = site->live_no;
+	site->live_amount -= size;
+	if(site->live_amount < site->budget_rearm) at_budget_arm(site);
+}
 
-	if(!ptr) return at_malloc(length, filename, function, line);
+/* record one step of a realloc chain, i.e. the growth (or shrinkage)
+   of a block from "size" to "nsize" bytes issued at "site" */
+static void at_site_realloc(at_site_t *site, at_heap_list_item_t *item,
+	size_t size, size_t nsize, char moved)
+{
+	double factor = 0.0;
 
-	if(((signed long)length) <= 0)
-	{
-		fprintf(stderr,
-			"[heap] invalid allocation request for %ld bytes detected\n",
-			((signed long)length));
-	}
+	if(!site) return;
 
-	item = (at_heap_list_item_t *)at_list_get(heap_list, ptr);
-	if(!item) return NULL;
-	item->pointer = (void *)realloc(ptr, length);
-	if(item->pointer) item->size = length;
-	else item->size = (long)(-1);
+	if(!(item->reallocs) || (item->site != site)) ++(site->realloc_chains);
+	++(site->realloc_no);
 
-	if(strcmp(item->filename, filename))
+	if(moved)
 	{
-		at_free_null(item->filename);
-		item->filename = (char *)malloc((strlen(filename) + 1) * sizeof(char));
-		strcpy(item->filename, filename);
+		++(site->realloc_moves);
+		site->realloc_copied += ((size < nsize) ? size : nsize);
 	}
 
-	if(strcmp(item->function, function))
+	if(size && (nsize > size))
 	{
-		at_free_null(item->function);
-		item->function = (char *)malloc((strlen(function) + 1) * sizeof(char));
-		strcpy(item->function, function);
-	}
+		factor = ((double)nsize / (double)size);
+		++(site->realloc_grown);
+		site->realloc_growth += factor;
 
-	item->line = line;
+		if(item->reallocs &&
+		   (((nsize - size) == item->increment) || (factor < AT_REALLOC_SLOW_GROWTH)))
+			++(site->realloc_linear);
+
+		item->increment = (nsize - size);
+	}
 
-	return item->pointer;
+	++(item->reallocs);
 }
 
-#if defined _XOPEN_SOURCE && _XOPEN_SOURCE >= 500 \
- || defined _POSIX_C_SOURCE && _POSIX_C_SOURCE >= 200809L \
- || defined _BSC_SOURCE || defined _SVID_SOURCE
-char *at_strdup(const char *string, const char *filename,
-	const char *function, int line)
+/* a block resized in another thread changes hands as well, but is
+   counted apart from the frees, as it is not released */
+static void at_site_free_thread(at_site_t *site, size_t producer, size_t consumer,
+	char resize)
 {
-	at_heap_list_item_t *item = NULL;
-	char *pointer = NULL;
+	size_t i = 0;
 
-	if(!string) return NULL;
-	if(!strlen(string)) return NULL;
-	item = at_heap_list_item_new(filename, function, line);
-	pointer = (char *)malloc((strlen(string) + 1) * sizeof(char));
+	if(!site || (producer == consumer)) return;
 
-	if(pointer)
+	if(resize) ++(site->remote_realloc_no);
+	else ++(site->remote_free_no);
+
+	for(i = 0; i < AT_SITE_THREAD_PAIRS; i++)
 	{
-		strcpy(pointer, string);
-		item->size = (strlen(pointer) + 1);
+		if(!(site->pairs[i].count))
+		{
+			site->pairs[i].producer = producer;
+			site->pairs[i].consumer = consumer;
+		}
+
+		if((site->pairs[i].producer == producer) &&
+		   (site->pairs[i].consumer == consumer))
+		{
+			++(site->pairs[i].count);
+			return;
+		}
 	}
 
-	item->pointer = pointer;
-	at_list_add(heap_list, (at_list_item_t *)item, AT_LIST_TYPE_HEAP);
-	return pointer;
+	++(site->pairs_other);
 }
-#endif
 
-#if defined __USE_XOPEN2K8 || __GLIBC_USE(LIB_EXT2) \
- || defined _POSIX_C_SOURCE && _POSIX_C_SOURCE >= 200809L \
- || defined _XOPEN_SOURCE && _XOPEN_SOURCE >= 700 \
- || defined _GNU_SOURCE
-size_t at_getline(char **outline, size_t *buflen, FILE *stream,
-	const char *filename, const char *function, int line)
+/* remember which thread last owned a small block in a cache line, so that
+   a line handed over to another thread by free and malloc can be noticed */
+static at_line_owner_t *at_line_owner(size_t line)
 {
-	return at_getdelim(outline, buflen, '\n', stream,
-	                   filename, function, line);
+	if(!line_owners)
+		line_owners = (at_line_owner_t *)at_meta_calloc(AT_LINE_OWNERS, sizeof(at_line_owner_t));
+	if(!line_owners) return NULL;
+	return &(line_owners[(at_index_hash((void *)line, AT_LINE_OWNERS))]);
 }
 
-size_t at_getdelim(char **outline, size_t *buflen, int delim, FILE *stream,
-	const char *filename, const char *function, int line)
+static void at_line_acquire(at_heap_list_item_t *item)
 {
-	at_heap_list_item_t *item = NULL;
-	size_t nbuflen = *buflen, linelen = 0;
-	char *preallocated = NULL;
-
-	if(!outline || !buflen || !stream) return (size_t)(-1);
+	at_line_owner_t *owner = NULL;
+	size_t line = 0, last = 0;
 
-	if(!(*outline)/* && !(*buflen)*/)
-	{
-		item = at_heap_list_item_new(filename, function, line);
-		if(delim == '\n') linelen = getline(outline, buflen, stream);
-		else linelen = getdelim(outline, buflen, delim, stream);
+	if(!(item->site) || !at_heap_item_size(item)) return;
+	if(at_heap_item_size(item) > AT_SHARING_SIZE) return;
 
-    if((linelen == (size_t)(-1)) &&
-       ((errno == EINVAL) || (errno == ENOMEM)))
-      return linelen;
+	line = ((size_t)(item->pointer) / AT_CACHE_LINE);
+	last = (((size_t)(item->pointer) + at_heap_item_size(item) - 1) / AT_CACHE_LINE);
 
-		item->size = *buflen;
-		item->pointer = *outline;
-		at_list_add(heap_list, (at_list_item_t *)item, AT_LIST_TYPE_HEAP);
-	}
-	else
+	for(; line <= last; line++)
 	{
-		preallocated = *outline;
-
-		if(delim == '\n') linelen = getline(outline, &nbuflen, stream);
-		else linelen = getdelim(outline, &nbuflen, delim, stream);
-
-    if((linelen == (size_t)(-1)) &&
-       ((errno == EINVAL) || (errno == ENOMEM)))
-      return linelen;
+		if(!(owner = at_line_owner(line))) return;
 
-		if(nbuflen > *buflen)
+		if((owner->line == line) && owner->site && (owner->thread != item->thread))
 		{
-			item = (at_heap_list_item_t *)at_list_get(heap_list, (void *)(*outline));
+			++(item->site->reuse_no);
+			item->site->reuse_site = owner->site;
+			return;
+		}
+	}
+}
 
-			if(item) item->size = nbuflen;
-			else
-			{
-				item = (at_heap_list_item_t *)at_list_get(heap_list, (void *)preallocated);
+static void at_line_release(at_heap_list_item_t *item)
+{
+	at_line_owner_t *owner = NULL;
+	size_t line = 0, last = 0;
 
-				if(item) /* ((preallocated != *outline) == true) implicitly holds */
-				{
-					item->pointer = *outline;
-					item->size = nbuflen;
-          /* "preallocated" has already been freed by "realloc"
-             inside "getline", or "getdelim", respectively */
-				}
-				/* else: buffer is not allocated on heap but on stack */
-			}
+	if(!(item->site) || !at_heap_item_size(item)) return;
+	if(at_heap_item_size(item) > AT_SHARING_SIZE) return;
 
-			*buflen = nbuflen;
-		}
-	}
+	line = ((size_t)(item->pointer) / AT_CACHE_LINE);
+	last = (((size_t)(item->pointer) + at_heap_item_size(item) - 1) / AT_CACHE_LINE);
 
-	return linelen;
+	for(; line <= last; line++)
+	{
+		if(!(owner = at_line_owner(line))) return;
+		owner->line = line;
+		owner->thread = item->thread;
+		owner->site = item->site;
+	}
 }
-#endif
 
-void at_free(void *pointer)
+/* the slot of a process is published under a sequence lock, so that
+   a reader in another process never sees a half-written slot */
+static void at_shm_begin(at_shm_slot_t *slot)
 {
-	if(!pointer) return;
-	at_list_remove(heap_list, pointer);
+	__atomic_store_n(&(slot->sequence), slot->sequence + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
 }
 
-FILE *at_fopen(const char *name, const char *mode, const char *filename,
-	const char *function, int line)
+static void at_shm_end(at_shm_slot_t *slot)
 {
-	at_file_list_item_t *item = NULL;
-
-	if(!name || !strlen(name)) return NULL;
-	if(!mode || !strlen(mode)) return NULL;
-
-	item = at_file_list_item_new(filename, function, line);
-	item->handle = fopen(name, mode);
-	item->name = (char *)malloc((strlen(name) + 1) * sizeof(char));
-	strcpy(item->name, name);
-	item->mode = (char *)malloc((strlen(mode) + 1) * sizeof(char));
-	strcpy(item->mode, mode);
-	at_list_add(file_list, (at_list_item_t *)item, AT_LIST_TYPE_FILE);
-	return item->handle;
+	__atomic_store_n(&(slot->sequence), slot->sequence + 1, __ATOMIC_RELEASE);
 }
 
-FILE *at_freopen(char *name, const char *mode, FILE *stream,
-	const char *filename, const char *function, int line)
+/* rank the sites by their live bytes, the ranking is only redone when
+   it might change, in between the amounts are refreshed in place */
+static void at_shm_top_sites(at_shm_slot_t *slot)
 {
-	at_file_list_item_t *item = NULL;
-	FILE *tmphandle = NULL;
-
-	if(!mode || !strlen(mode)) return NULL;
-	if(!stream) return NULL;
+	at_site_t *site = NULL;
+	size_t i = 0, j = 0, k = 0;
 
-	item = (at_file_list_item_t *)at_list_get(file_list, (void *)stream);
+	memset(shm_top, '\0', sizeof(shm_top));
 
-	if(item)
+	for(i = 0; i < site_table.length; i++)
 	{
-		if(!name) name = item->name;
+		site = site_table.sites[i];
+		if(!(site->live_amount)) continue;
 
-		if(item->name && !strcmp(item->name, name))
-		{
-			if(strcmp(item->mode, mode))
-			{
-				at_free_null(item->mode);
-				item->mode = (char *)malloc((strlen(mode) + 1) * sizeof(char));
-				strcpy(item->mode, mode);
-			}
-		}
-		else
-		{
-			at_list_remove(file_list, (void *)stream);
-			item = NULL;
-		}
+		for(j = 0; j < AT_SHM_TOP_SITES; j++)
+			if(!shm_top[j] || (site->live_amount > shm_top[j]->live_amount)) break;
+
+		if(j == AT_SHM_TOP_SITES) continue;
+		for(k = (AT_SHM_TOP_SITES - 1); k > j; k--) shm_top[k] = shm_top[(k - 1)];
+		shm_top[j] = site;
 	}
 
-	if(!item)
+	for(j = 0; j < AT_SHM_TOP_SITES; j++)
 	{
-		item = at_file_list_item_new(filename, function, line);
+		memset(&(slot->sites[j]), '\0', sizeof(at_shm_site_t));
+		if(!shm_top[j]) continue;
 
-		if(name)
-		{
-			item->name = (char *)malloc((strlen(name) + 1) * sizeof(char));
-			strcpy(item->name, name);
-		}
-		else item->name = NULL;
+		snprintf(slot->sites[j].name, AT_SHM_SITE_NAME, "%s:%d",
+			at_basename(shm_top[j]->filename), shm_top[j]->line);
+	}
+}
 
-		item->mode = (char *)malloc((strlen(mode) + 1) * sizeof(char));
-		strcpy(item->mode, mode);
+/* the ranking is redone when one of its sites emptied or fell behind the
+   next one, which also covers releases not naming a site, or when "site"
+   outgrows a ranked site; a site outside of the ranking only enters it
+   by growing */
+static char at_shm_ranks(at_site_t *site)
+{
+	size_t j = 0;
 
-		if((item->handle = freopen(name, mode, stream)))
-			at_list_add(file_list, (at_list_item_t *)item, AT_LIST_TYPE_FILE);
-		else
-		{
-			at_track_stats_release((at_list_item_t *)item, AT_LIST_TYPE_FILE);
-			at_list_free_item((at_list_item_t **)&item, AT_LIST_TYPE_FILE);
-		}
+	for(j = 0; (j < AT_SHM_TOP_SITES) && shm_top[j]; j++)
+	{
+		if(!(shm_top[j]->live_amount)) return (char)1;
+
+		if(((j + 1) < AT_SHM_TOP_SITES) && shm_top[(j + 1)] &&
+		   (shm_top[j]->live_amount < shm_top[(j + 1)]->live_amount))
+			return (char)1;
 	}
-	else
+
+	if(!site || !(site->live_amount)) return (char)0;
+
+	for(j = 0; j < AT_SHM_TOP_SITES; j++)
 	{
-		tmphandle = freopen(name, mode, stream);
+		if(!shm_top[j] || (shm_top[j] == site)) return (char)!shm_top[j];
+		if(site->live_amount > shm_top[j]->live_amount) return (char)1;
+	}
 
-		if(tmphandle && (tmphandle != (item->handle)))
-		{
-			at_list_remove(file_list, (void *)(item->handle));
+	return (char)0;
+}
 
-			item = at_file_list_item_new(filename, function, line);
+/* counters are published relative to the moment the slot was claimed,
+   so that a forked child starts with a clean slot */
+static void at_shm_update(at_site_t *site)
+{
+	size_t j = 0;
 
-			if(name)
-			{
-				item->name = (char *)malloc((strlen(name) + 1) * sizeof(char));
-				strcpy(item->name, name);
-			}
-			else item->name = NULL;
+	if(!shm_slot) return;
 
-			item->mode = (char *)malloc((strlen(mode) + 1) * sizeof(char));
-			strcpy(item->mode, mode);
+	at_shm_begin(shm_slot);
+	shm_slot->stats.alloc_amount = (stats.alloc_amount - shm_base.alloc_amount);
+	shm_slot->stats.alloc_no = (stats.alloc_no - shm_base.alloc_no);
+	shm_slot->stats.free_amount = (stats.free_amount - shm_base.free_amount);
+	shm_slot->stats.free_no = (stats.free_no - shm_base.free_no);
+	shm_slot->stats.open_no = (stats.open_no - shm_base.open_no);
+	shm_slot->stats.close_no = (stats.close_no - shm_base.close_no);
+	shm_slot->live_amount = heap_live_amount;
+	shm_slot->peak_amount = heap_peak_amount;
 
-			item->handle = tmphandle;
+	if(at_shm_ranks(site)) at_shm_top_sites(shm_slot);
 
-			at_list_add(file_list, (at_list_item_t *)item, AT_LIST_TYPE_FILE);
-		}
-		else
-		{
+	for(j = 0; (j < AT_SHM_TOP_SITES) && shm_top[j]; j++)
+	{
+		shm_slot->sites[j].live_amount = shm_top[j]->live_amount;
+		shm_slot->sites[j].live_no = shm_top[j]->live_no;
+	}
+
+	at_shm_end(shm_slot);
+}
+
+/* claim a free slot for the calling process, slots left behind by
+   processes which no longer exist are taken over */
+static at_shm_slot_t *at_shm_claim(void)
+{
+	at_shm_slot_t *slot = NULL;
+	size_t i = 0;
+	int pid = (int)getpid(), owner = 0, error = errno;
+
+	for(i = 0; i < shm_segment->slot_no; i++)
+	{
+		slot = &(shm_segment->slots[i]);
+		owner = __atomic_load_n(&(slot->pid), __ATOMIC_ACQUIRE);
+		if(owner && ((kill(owner, 0) == 0) || (errno != ESRCH))) continue;
+
+		if(__atomic_compare_exchange_n(&(slot->pid), &owner, pid, 0,
+		                               __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+		{
+			at_shm_begin(slot);
+			memset(&(slot->stats), '\0', sizeof(at_track_stats_t));
+			slot->live_amount = slot->peak_amount = 0;
+			memset(slot->sites, '\0', sizeof(slot->sites));
+			at_shm_end(slot);
+
+			memcpy(&shm_base, &stats, sizeof(at_track_stats_t));
+			at_shm_top_sites(slot);
+			errno = error;
+			return slot;
+		}
+	}
+
+	errno = error;
+	return NULL;
+}
+
+static void at_shm_release(void)
+{
+	if(shm_slot) __atomic_store_n(&(shm_slot->pid), 0, __ATOMIC_RELEASE);
+	if(shm_segment) munmap(shm_segment, sizeof(at_shm_segment_t));
+	memset(shm_top, '\0', sizeof(shm_top));
+	shm_segment = NULL;
+	shm_slot = NULL;
+}
+
+static void at_fault_close(void)
+{
+	size_t i = 0;
+
+	for(i = 0; i < fault_event_no; i++)
+	{
+		munmap(fault_events[i].ring, ((1 + AT_FAULT_PAGES) * (size_t)sysconf(_SC_PAGESIZE)));
+		close(fault_events[i].fd);
+	}
+
+	fault_event_no = 0;
+}
+
+/* the periodic threads wait for points in time on the monotonic clock,
+   which does not jump along with the wall clock */
+static void at_wake_init(pthread_cond_t *wake)
+{
+	pthread_condattr_t monotonic;
+
+	pthread_condattr_init(&monotonic);
+	pthread_condattr_setclock(&monotonic, CLOCK_MONOTONIC);
+	pthread_cond_init(wake, &monotonic);
+	pthread_condattr_destroy(&monotonic);
+}
+
+/* the lock is held across "fork", so that the child inherits consistent
+   lists; the forking thread is the only one left in the child, whose
+   copy of the lock is reset rather than unlocked (it has a new thread id) */
+static void at_fork_prepare(void)
+{
+	AT_LOCK();
+}
+
+static void at_fork_parent(void)
+{
+	AT_UNLOCK();
+}
+
+static void at_fork_child(void)
+{
+	pthread_mutexattr_t recursive;
+
+	pthread_mutexattr_init(&recursive);
+	pthread_mutexattr_settype(&recursive, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(&lock, &recursive);
+	pthread_mutexattr_destroy(&recursive);
+	heap_peak_amount = heap_live_amount;
+
+	/* the sampler thread is not forked along, nor is its ring file */
+	pthread_mutex_init(&sampler_control, NULL);
+	pthread_mutex_init(&sampler_lock, NULL);
+	at_wake_init(&sampler_wake);
+	sampler_stopping = (char)0;
+
+	/* neither are the leak scan and dump threads, the child has to call
+	   "at_dump_on_signal" again for dumps to be written; the handlers
+	   replaced in the parent are still the ones restored */
+	pthread_mutex_init(&leak_control, NULL);
+	pthread_mutex_init(&leak_lock, NULL);
+	at_wake_init(&leak_wake);
+	leak_stopping = (char)0;
+	leak_interval = 0;
+	leak_cursor = NULL;
+	leak_scanning = (char)0;
+	dump_armed = (char)0;
+
+	/* nor is the page fault thread, and the events belong to the parent */
+	pthread_mutex_init(&fault_control, NULL);
+	pthread_mutex_init(&fault_lock, NULL);
+	at_wake_init(&fault_wake);
+	fault_stopping = (char)0;
+	fault_interval = 0;
+	at_fault_close();
+
+	/* stopped threads of the child must not acknowledge to the parent */
+	if(reach_ack[0] >= 0)
+	{
+		close(reach_ack[0]);
+		close(reach_ack[1]);
+		if(pipe2(reach_ack, O_CLOEXEC) != 0) reach_ack[0] = reach_ack[1] = -1;
+	}
+
+	if(sampler_ring)
+	{
+		munmap(sampler_ring, (sizeof(at_sample_ring_t) +
+		       (sampler_ring->capacity * sizeof(at_sample_t))));
+		sampler_ring = NULL;
+	}
+
+	if(!shm_segment) return;
+	if(!(shm_slot = at_shm_claim()))
+		fprintf(stderr, "[shm] no free slot for process %d\n", (int)getpid());
+	at_shm_update(NULL);
+}
+
+static void at_track_stats_init(void)
+{
+	if(can_record) return;
+	memset(&stats, '\0', sizeof(at_track_stats_t));
+	memset(&map_stats, '\0', sizeof(at_map_stats_t));
+	memset(&fd_stats, '\0', sizeof(at_fd_stats_t));
+	memset(class_counts, '\0', sizeof(class_counts));
+	memset(class_amounts, '\0', sizeof(class_amounts));
+	class_large_no = 0;
+	pthread_atfork(at_fork_prepare, at_fork_parent, at_fork_child);
+	can_record = (char)1;
+
+	if(!can_report)
+	{
+		if((heap_list && heap_list->length) || compact.live ||
+		   (file_list && file_list->length) ||
+		   (map_list && map_list->length) ||
+		   fd_table.length)
+			 can_report = (char)1;
+	 }
+}
+
+int at_shm_publish(const char *name)
+{
+	struct stat info;
+	void *segment = NULL;
+	int fd = -1;
+
+	if(!name || !strlen(name)) return -1;
+	AT_LOCK();
+
+	if(shm_segment)
+	{
+		AT_UNLOCK();
+		return 0;
+	}
+
+	if(!can_record) at_track_stats_init();
+
+	if(((fd = shm_open(name, (O_RDWR | O_CREAT), 0600)) < 0) || (fstat(fd, &info) != 0) ||
+	   (info.st_size && ((size_t)(info.st_size) != sizeof(at_shm_segment_t))) ||
+	   (ftruncate(fd, sizeof(at_shm_segment_t)) != 0))
+	{
+		fprintf(stderr, "[shm] failed to open segment \"%s\"\n", name);
+		if(fd >= 0) close(fd);
+		AT_UNLOCK();
+		return -1;
+	}
+
+	segment = mmap(NULL, sizeof(at_shm_segment_t), (PROT_READ | PROT_WRITE), MAP_SHARED, fd, 0);
+	close(fd);
+
+	if(segment == MAP_FAILED)
+	{
+		fprintf(stderr, "[shm] failed to map segment \"%s\"\n", name);
+		AT_UNLOCK();
+		return -1;
+	}
+
+	shm_segment = (at_shm_segment_t *)segment;
+	__atomic_store_n(&(shm_segment->slot_no), (size_t)AT_SHM_SLOTS, __ATOMIC_RELAXED);
+	__atomic_store_n(&(shm_segment->magic), AT_SHM_MAGIC, __ATOMIC_RELEASE);
+
+	if(!(shm_slot = at_shm_claim()))
+	{
+		fprintf(stderr, "[shm] no free slot in segment \"%s\"\n", name);
+		at_shm_release();
+		AT_UNLOCK();
+		return -1;
+	}
+
+	at_shm_update(NULL);
+	AT_UNLOCK();
+	return 0;
+}
+
+static void at_sampler_record(void)
+{
+	at_sample_t *sample = NULL;
+	at_site_t *top[AT_SAMPLE_TOP_SITES], *site = NULL;
+	int64_t growth[AT_SAMPLE_TOP_SITES], delta = 0;
+	struct timespec now;
+	size_t i = 0, j = 0, k = 0;
+
+	clock_gettime(CLOCK_REALTIME, &now);
+	AT_LOCK();
+
+	sample = &(((at_sample_t *)(sampler_ring + 1))[(sampler_ring->written % sampler_ring->capacity)]);
+	memset(sample, '\0', sizeof(at_sample_t));
+	sample->time = (((uint64_t)(now.tv_sec) * 1000000000) + (uint64_t)(now.tv_nsec));
+	sample->alloc_amount = (stats.alloc_amount - sampler_last.alloc_amount);
+	sample->alloc_no = (stats.alloc_no - sampler_last.alloc_no);
+	sample->free_amount = (stats.free_amount - sampler_last.free_amount);
+	sample->free_no = (stats.free_no - sampler_last.free_no);
+	sample->live_amount = heap_live_amount;
+	sample->live_no = at_list_length(heap_list);
+	sample->file_no = at_list_length(file_list);
+	sample->fd_no = fd_table.length;
+	memcpy(&sampler_last, &stats, sizeof(at_track_stats_t));
+
+	/* the sites whose live bytes grew most since the previous sample */
+	memset(top, '\0', sizeof(top));
+
+	for(i = 0; i < site_table.length; i++)
+	{
+		site = site_table.sites[i];
+		delta = ((int64_t)(site->live_amount) - (int64_t)(site->sample_amount));
+		site->sample_amount = site->live_amount;
+		if(delta <= 0) continue;
+
+		for(j = 0; j < AT_SAMPLE_TOP_SITES; j++)
+			if(!top[j] || (delta > growth[j])) break;
+
+		if(j == AT_SAMPLE_TOP_SITES) continue;
+
+		for(k = (AT_SAMPLE_TOP_SITES - 1); k > j; k--)
+		{
+			top[k] = top[(k - 1)];
+			growth[k] = growth[(k - 1)];
+		}
+
+		top[j] = site;
+		growth[j] = delta;
+	}
+
+	for(j = 0; (j < AT_SAMPLE_TOP_SITES) && top[j]; j++)
+	{
+		snprintf(sample->sites[j].name, AT_SHM_SITE_NAME, "%s:%d",
+			at_basename(top[j]->filename), top[j]->line);
+		sample->sites[j].growth = growth[j];
+		sample->sites[j].live_amount = top[j]->live_amount;
+	}
+
+	__atomic_store_n(&(sampler_ring->written), (sampler_ring->written + 1), __ATOMIC_RELEASE);
+	AT_UNLOCK();
+}
+
+static void at_deadline_advance(struct timespec *until, unsigned int interval)
+{
+	until->tv_sec += (time_t)(interval / 1000);
+	until->tv_nsec += (long)((interval % 1000) * 1000000);
+
+	if(until->tv_nsec >= 1000000000)
+	{
+		++(until->tv_sec);
+		until->tv_nsec -= 1000000000;
+	}
+}
+
+/* samples are taken at fixed points in time, so that a slow sample
+   does not shift all of the following ones */
+static void *at_sampler_run(void *unused)
+{
+	struct timespec until;
+
+	(void)unused;
+	clock_gettime(CLOCK_MONOTONIC, &until);
+	pthread_mutex_lock(&sampler_lock);
+
+	while(!sampler_stopping)
+	{
+		at_deadline_advance(&until, sampler_ring->interval);
+
+		while(!sampler_stopping &&
+		      (pthread_cond_timedwait(&sampler_wake, &sampler_lock, &until) != ETIMEDOUT));
+
+		if(!sampler_stopping) at_sampler_record();
+	}
+
+	pthread_mutex_unlock(&sampler_lock);
+	return NULL;
+}
+
+int at_sampler_start(const char *path, unsigned int interval, size_t capacity)
+{
+	at_sample_ring_t *ring = NULL;
+	void *mapping = NULL;
+	size_t size = 0, i = 0;
+	int fd = -1;
+
+	if(!path || !strlen(path) || !interval || !capacity) return -1;
+	pthread_mutex_lock(&sampler_control);
+
+	if(sampler_ring)
+	{
+		pthread_mutex_unlock(&sampler_control);
+		return 0;
+	}
+
+	size = (sizeof(at_sample_ring_t) + (capacity * sizeof(at_sample_t)));
+
+	if(((fd = open(path, (O_RDWR | O_CREAT | O_TRUNC), 0644)) < 0) ||
+	   (ftruncate(fd, (off_t)size) != 0) ||
+	   ((mapping = mmap(NULL, size, (PROT_READ | PROT_WRITE), MAP_SHARED, fd, 0)) == MAP_FAILED))
+	{
+		fprintf(stderr, "[sampler] failed to map ring file \"%s\"\n", path);
+		if(fd >= 0) close(fd);
+		pthread_mutex_unlock(&sampler_control);
+		return -1;
+	}
+
+	close(fd);
+	ring = (at_sample_ring_t *)mapping;
+	ring->sample_size = sizeof(at_sample_t);
+	ring->capacity = capacity;
+	ring->interval = interval;
+	ring->written = 0;
+	__atomic_store_n(&(ring->magic), AT_SAMPLE_MAGIC, __ATOMIC_RELEASE);
+
+	AT_LOCK();
+	if(!can_record) at_track_stats_init();
+	memcpy(&sampler_last, &stats, sizeof(at_track_stats_t));
+
+	for(i = 0; i < site_table.length; i++)
+		site_table.sites[i]->sample_amount = site_table.sites[i]->live_amount;
+
+	sampler_ring = ring;
+	AT_UNLOCK();
+
+	sampler_stopping = (char)0;
+	at_wake_init(&sampler_wake);
+
+	if(pthread_create(&sampler_thread, NULL, at_sampler_run, NULL) != 0)
+	{
+		fprintf(stderr, "[sampler] failed to start sampler thread\n");
+		AT_LOCK();
+		sampler_ring = NULL;
+		AT_UNLOCK();
+		munmap(mapping, size);
+		pthread_mutex_unlock(&sampler_control);
+		return -1;
+	}
+
+	pthread_mutex_unlock(&sampler_control);
+	return 0;
+}
+
+void at_sampler_stop(void)
+{
+	at_sample_ring_t *ring = NULL;
+
+	pthread_mutex_lock(&sampler_control);
+
+	if(!sampler_ring)
+	{
+		pthread_mutex_unlock(&sampler_control);
+		return;
+	}
+
+	pthread_mutex_lock(&sampler_lock);
+	sampler_stopping = (char)1;
+	pthread_cond_signal(&sampler_wake);
+	pthread_mutex_unlock(&sampler_lock);
+	pthread_join(sampler_thread, NULL);
+
+	AT_LOCK();
+	ring = sampler_ring;
+	sampler_ring = NULL;
+	AT_UNLOCK();
+
+	munmap(ring, (sizeof(at_sample_ring_t) + (ring->capacity * sizeof(at_sample_t))));
+	pthread_mutex_unlock(&sampler_control);
+}
+
+
+/* the leak scan walks "heap_list" a slice at a time; a block counts as old
+   once it has outlived a whole pass, and a site is suspected the more of
+   its blocks are old and the more passes its live count grew without ever
+   dropping in between */
+static uint64_t at_leak_clock(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+	return (((uint64_t)now.tv_sec * 1000) + (uint64_t)(now.tv_nsec / 1000000));
+}
+
+static void at_leak_finish(void)
+{
+	at_site_t *site = NULL;
+	size_t i = 0, streak = 0;
+
+	for(i = 0; i < site_table.length; i++)
+	{
+		site = site_table.sites[i];
+
+		if((site->live_no > site->leak_live) && (site->leak_low >= site->leak_live))
+			++(site->leak_streak);
+		else if(site->live_no < site->leak_live) site->leak_streak = 0;
+
+		site->leak_live = site->leak_low = site->live_no;
+		site->leak_old_no = site->leak_pending;
+		site->leak_oldest = site->leak_pending_age;
+		site->leak_pending = 0;
+		site->leak_pending_age = 0;
+
+		streak = ((site->leak_streak < AT_LEAK_STREAK) ? site->leak_streak : AT_LEAK_STREAK);
+		site->leak_score = (site->live_no ? (unsigned int)(((site->leak_old_no * 100) /
+			site->live_no) * streak / AT_LEAK_STREAK) : 0);
+	}
+
+	leak_scanning = (char)0;
+	++leak_pass_no;
+}
+
+/* returns nonzero once a pass is complete */
+static char at_leak_slice(void)
+{
+	at_heap_list_item_t *item = NULL;
+	uint64_t now = at_leak_clock();
+	size_t n = 0;
+
+	if(!leak_scanning)
+	{
+		leak_prev_start = leak_pass_start;
+		leak_pass_start = now;
+		leak_cursor = (heap_list ? (at_heap_list_item_t *)(heap_list->first) : NULL);
+		leak_scanning = (char)1;
+	}
+
+	while(leak_cursor && (n++ < AT_LEAK_SLICE))
+	{
+		item = leak_cursor;
+		leak_cursor = item->next;
+
+		if(!(item->site) || (item->birth > leak_prev_start)) continue;
+		++(item->site->leak_pending);
+		if((now - item->birth) > item->site->leak_pending_age)
+			item->site->leak_pending_age = (now - item->birth);
+	}
+
+	if(leak_cursor) return (char)0;
+	at_leak_finish();
+	return (char)1;
+}
+
+static void *at_leak_run(void *unused)
+{
+	struct timespec until;
+	char done = (char)1;
+
+	(void)unused;
+	clock_gettime(CLOCK_MONOTONIC, &until);
+	pthread_mutex_lock(&leak_lock);
+
+	while(!leak_stopping)
+	{
+		at_deadline_advance(&until, (done ? leak_interval : AT_LEAK_SLICE_GAP));
+
+		while(!leak_stopping &&
+		      (pthread_cond_timedwait(&leak_wake, &leak_lock, &until) != ETIMEDOUT));
+
+		if(leak_stopping) break;
+
+		AT_LOCK();
+		done = at_leak_slice();
+		AT_UNLOCK();
+	}
+
+	pthread_mutex_unlock(&leak_lock);
+	return NULL;
+}
+
+int at_leak_scan_start(unsigned int interval)
+{
+	size_t i = 0;
+
+	if(!interval) return -1;
+	pthread_mutex_lock(&leak_control);
+
+	if(leak_interval)
+	{
+		pthread_mutex_unlock(&leak_control);
+		return 0;
+	}
+
+	AT_LOCK();
+	if(!can_record) at_track_stats_init();
+
+	/* growth is counted from here on */
+	for(i = 0; i < site_table.length; i++)
+		site_table.sites[i]->leak_live = site_table.sites[i]->leak_low =
+			site_table.sites[i]->live_no;
+
+	leak_pass_start = at_leak_clock();
+	leak_cursor = NULL;
+	leak_scanning = (char)0;
+	AT_UNLOCK();
+
+	leak_interval = interval;
+	leak_stopping = (char)0;
+	at_wake_init(&leak_wake);
+
+	if(pthread_create(&leak_thread, NULL, at_leak_run, NULL) != 0)
+	{
+		fprintf(stderr, "[leak] failed to start leak scan thread\n");
+		leak_interval = 0;
+		pthread_mutex_unlock(&leak_control);
+		return -1;
+	}
+
+	pthread_mutex_unlock(&leak_control);
+	return 0;
+}
+
+void at_leak_scan_stop(void)
+{
+	pthread_mutex_lock(&leak_control);
+
+	if(!leak_interval)
+	{
+		pthread_mutex_unlock(&leak_control);
+		return;
+	}
+
+	pthread_mutex_lock(&leak_lock);
+	leak_stopping = (char)1;
+	pthread_cond_signal(&leak_wake);
+	pthread_mutex_unlock(&leak_lock);
+	pthread_join(leak_thread, NULL);
+	leak_interval = 0;
+
+	AT_LOCK();
+	leak_cursor = NULL;
+	leak_scanning = (char)0;
+	AT_UNLOCK();
+
+	pthread_mutex_unlock(&leak_control);
+}
+
+/* completes the pass in progress, or a whole new one, right away; returns
+   the number of passes completed so far */
+int at_leak_pass(void)
+{
+	size_t passes = 0;
+
+	AT_LOCK();
+	if(!can_record) at_track_stats_init();
+	while(!at_leak_slice());
+	passes = leak_pass_no;
+	AT_UNLOCK();
+	return (int)passes;
+}
+
+static int at_leak_compare(const void *a, const void *b)
+{
+	const at_site_t *x = *(const at_site_t * const *)a;
+	const at_site_t *y = *(const at_site_t * const *)b;
+
+	if(x->leak_score != y->leak_score) return ((x->leak_score > y->leak_score) ? -1 : 1);
+	if(x->live_amount != y->live_amount) return ((x->live_amount > y->live_amount) ? -1 : 1);
+	return 0;
+}
+
+/* collects the suspected sites still holding blocks ordered by score, as
+   of the last complete pass; the caller frees them */
+static size_t at_leak_collect(at_site_t ***suspects)
+{
+	size_t i = 0, length = 0;
+
+	*suspects = NULL;
+	if(!leak_pass_no || !(site_table.length)) return 0;
+	if(!(*suspects = (at_site_t **)at_meta_malloc(site_table.length * sizeof(at_site_t *)))) return 0;
+
+	for(i = 0; i < site_table.length; i++)
+		if(site_table.sites[i]->leak_score && site_table.sites[i]->live_no)
+			(*suspects)[length++] = site_table.sites[i];
+
+	qsort(*suspects, length, sizeof(at_site_t *), at_leak_compare);
+	return length;
+}
+
+int at_leak_suspects(at_leak_suspect_t *suspects, size_t length)
+{
+	at_site_t **sites = NULL;
+	size_t found = 0, i = 0;
+
+	if(!suspects) return -1;
+
+	AT_LOCK();
+	found = at_leak_collect(&sites);
+
+	for(i = 0; (i < found) && (i < length); i++)
+	{
+		suspects[i].filename = sites[i]->filename;
+		suspects[i].function = sites[i]->function;
+		suspects[i].line = sites[i]->line;
+		suspects[i].score = sites[i]->leak_score;
+		suspects[i].live_no = sites[i]->live_no;
+		suspects[i].live_amount = sites[i]->live_amount;
+		suspects[i].old_no = sites[i]->leak_old_no;
+		suspects[i].oldest = sites[i]->leak_oldest;
+		suspects[i].streak = sites[i]->leak_streak;
+	}
+
+	at_meta_free_null(sites);
+	AT_UNLOCK();
+	return (int)i;
+}
+
+/* request sizes are counted in granules for the size classes, and every
+   site elects its most frequent size by a majority vote, the hits being
+   counted since the current candidate was elected */
+static void at_class_record(at_site_t *site, size_t size)
+{
+	size_t granule = ((size + AT_CLASS_GRANULE - 1) / AT_CLASS_GRANULE);
+
+	if(size <= AT_CLASS_LIMIT)
+	{
+		++(class_counts[granule]);
+		class_amounts[granule] += size;
+	}
+	else ++class_large_no;
+
+	if(!site) return;
+
+	if(site->size_votes && (site->size_major == size))
+	{
+		++(site->size_votes);
+		++(site->size_hits);
+	}
+	else if(!(site->size_votes))
+	{
+		site->size_major = size;
+		site->size_votes = site->size_hits = 1;
+	}
+	else --(site->size_votes);
+}
+
+static void at_track_stats_aquire(at_list_item_t *item, at_list_type_t type)
+{
+	at_heap_list_item_t *heap_item = NULL;
+	at_map_list_item_t *map_item = NULL;
+
+	if(!item) return;
+	if(!can_record) at_track_stats_init();
+
+	if(type == AT_LIST_TYPE_HEAP)
+	{
+		heap_item = (at_heap_list_item_t *)item;
+		stats.alloc_amount += heap_item->size;
+		++(stats.alloc_no);
+
+		at_scope_acquire(heap_item->scope, at_heap_item_size(heap_item));
+
+		if(heap_item->site)
+		{
+			++(heap_item->site->alloc_no);
+			heap_item->site->alloc_amount += at_heap_item_size(heap_item);
+			at_site_acquire(heap_item->site, at_heap_item_size(heap_item));
+			at_line_acquire(heap_item);
+		}
+
+		at_class_record(heap_item->site, at_heap_item_size(heap_item));
+	}
+	else if(type == AT_LIST_TYPE_FILE) ++(stats.open_no);
+	else if(type == AT_LIST_TYPE_MAP)
+	{
+		map_item = (at_map_list_item_t *)item;
+		map_stats.map_amount += map_item->size;
+		++(map_stats.map_no);
+		if(map_item->pagesize) map_stats.huge_amount += map_item->size;
+
+		if((map_stats.map_amount - map_stats.unmap_amount) > map_stats.peak_amount)
+			map_stats.peak_amount = (map_stats.map_amount - map_stats.unmap_amount);
+	}
+
+	at_shm_update(heap_item ? heap_item->site : NULL);
+}
+
+static void at_track_stats_release(at_list_item_t *item, at_list_type_t type)
+{
+	at_heap_list_item_t *heap_item = NULL;
+	at_map_list_item_t *map_item = NULL;
+
+	if(!item) return;
+	if(!can_record) at_track_stats_init();
+
+	if(type == AT_LIST_TYPE_HEAP)
+	{
+		heap_item = (at_heap_list_item_t *)item;
+		stats.free_amount += heap_item->size;
+		++(stats.free_no);
+
+		at_scope_release(heap_item->scope, at_heap_item_size(heap_item));
+
+		if(heap_item->site)
+		{
+			++(heap_item->site->free_no);
+			heap_item->site->lifetime_sum += (at_leak_clock() - heap_item->birth);
+			++(heap_item->site->lifetime_no);
+			at_site_release(heap_item->site, at_heap_item_size(heap_item));
+			at_line_release(heap_item);
+		}
+	}
+	else if(type == AT_LIST_TYPE_FILE) ++(stats.close_no);
+	else if(type == AT_LIST_TYPE_MAP)
+	{
+		map_item = (at_map_list_item_t *)item;
+		map_stats.unmap_amount += map_item->size;
+		++(map_stats.unmap_no);
+	}
+
+	at_shm_update(NULL);
+}
+
+static void *at_meta_chunk_alloc(at_meta_chunk_t **chunks, size_t size)
+{
+	at_meta_chunk_t *chunk = *chunks;
+	size_t offset = ((sizeof(at_meta_chunk_t) + 15) & ~(size_t)15);
+
+	size = ((size + 15) & ~(size_t)15);
+
+	if(!chunk || ((offset + chunk->used + size) > AT_META_CHUNK))
+	{
+		chunk = (at_meta_chunk_t *)at_meta_malloc(offset +
+			((size > (AT_META_CHUNK - offset)) ? size : (AT_META_CHUNK - offset)));
+		if(!chunk) return NULL;
+		chunk->next = *chunks;
+		chunk->used = 0;
+		*chunks = chunk;
+	}
+
+	chunk->used += size;
+	return ((char *)chunk + offset + chunk->used - size);
+}
+
+static void at_meta_chunks_free(at_meta_chunk_t **chunks)
+{
+	at_meta_chunk_t *chunk = NULL;
+
+	while((chunk = *chunks))
+	{
+		*chunks = chunk->next;
+		at_meta_free(chunk);
+	}
+}
+
+static size_t at_list_item_size(at_list_type_t type)
+{
+	if(type == AT_LIST_TYPE_HEAP) return sizeof(at_heap_list_item_t);
+	else if(type == AT_LIST_TYPE_FILE) return sizeof(at_file_list_item_t);
+	return sizeof(at_map_list_item_t);
+}
+
+/* freed items are kept for reuse until their list is freed */
+static void *at_meta_pool_get(at_list_type_t type)
+{
+	at_meta_pool_t *pool = &(item_pools[type]);
+	at_list_item_t *item = NULL;
+
+	if(!(item = pool->recycled))
+		return at_meta_chunk_alloc(&(pool->chunks), at_list_item_size(type));
+
+	pool->recycled = item->next;
+	return item;
+}
+
+static void at_meta_pool_put(at_list_item_t *item, at_list_type_t type)
+{
+	item->next = item_pools[type].recycled;
+	item_pools[type].recycled = item;
+}
+
+static void at_meta_pool_free(at_list_type_t type)
+{
+	at_meta_chunks_free(&(item_pools[type].chunks));
+	item_pools[type].recycled = NULL;
+}
+
+static size_t at_meta_string_slot(const char *str)
+{
+	const unsigned char *c = (const unsigned char *)str;
+	uint64_t hash = 14695981039346656037ULL;
+	size_t slot = 0;
+
+	while(*c) hash = ((hash ^ *(c++)) * 1099511628211ULL);
+
+	slot = (size_t)(hash & (string_table.capacity - 1));
+
+	while(string_table.slots[slot] && strcmp(string_table.slots[slot], str))
+		slot = ((slot + 1) & (string_table.capacity - 1));
+
+	return slot;
+}
+
+/* the origins of list items are few distinct strings, so every item shares
+   a single copy instead of owning one */
+static char *at_meta_intern(const char *str)
+{
+	char **slots = string_table.slots;
+	size_t capacity = string_table.capacity, i = 0, slot = 0;
+
+	if(!str) return NULL;
+
+	if(((string_table.length + 1) * 2) > string_table.capacity)
+	{
+		string_table.capacity = (capacity ? (capacity * 2) : 256);
+		string_table.slots = (char **)at_meta_calloc(string_table.capacity, sizeof(char *));
+
+		if(!(string_table.slots))
+		{
+			string_table.slots = slots;
+			string_table.capacity = capacity;
+			if(!capacity) return NULL;
+		}
+		else
+		{
+			for(i = 0; i < capacity; i++)
+				if(slots[i]) string_table.slots[at_meta_string_slot(slots[i])] = slots[i];
+
+			at_meta_free_null(slots);
+		}
+	}
+
+	slot = at_meta_string_slot(str);
+
+	if(!(string_table.slots[slot]))
+	{
+		if(string_table.length >= (string_table.capacity - 1)) return NULL;
+		if(!(string_table.slots[slot] =
+		     (char *)at_meta_chunk_alloc(&(string_table.chunks), (strlen(str) + 1))))
+			return NULL;
+
+		strcpy(string_table.slots[slot], str);
+		++(string_table.length);
+	}
+
+	return string_table.slots[slot];
+}
+
+static void at_meta_strings_free(void)
+{
+	at_meta_chunks_free(&(string_table.chunks));
+	at_meta_free_null(string_table.slots);
+	string_table.capacity = string_table.length = 0;
+}
+
+at_heap_list_item_t *at_heap_list_item_new(const char *filename, const char *function, int line)
+{
+	at_heap_list_item_t *item = NULL;
+
+	item = (at_heap_list_item_t *)at_meta_pool_get(AT_LIST_TYPE_HEAP);
+	if(!item) return NULL;
+
+	item->filename = at_meta_intern(filename);
+	item->function = at_meta_intern(function);
+
+	item->line = line;
+	item->id = (heap_id_counter++);
+	item->prev = item->next = NULL;
+	item->pointer = NULL;
+	item->size = 0;
+	item->alignment = 0;
+	item->site = at_site_get(filename, function, line);
+	item->scope = at_scope_current();
+	item->thread = at_thread_self();
+	item->reallocs = 0;
+	item->increment = 0;
+	item->kind = AT_ALLOC_KIND_MALLOC;
+	item->birth = at_leak_clock();
+	item->touched = 0;
+	item->zeroed = (char)0;
+	return item;
+}
+
+at_file_list_item_t *at_file_list_item_new(const char *filename, const char *function, int line)
+{
+	at_file_list_item_t *item = NULL;
+
+	item = (at_file_list_item_t *)at_meta_pool_get(AT_LIST_TYPE_FILE);
+	if(!item) return NULL;
+
+	item->filename = at_meta_intern(filename);
+	item->function = at_meta_intern(function);
+
+	item->line = line;
+	item->id = (file_id_counter++);
+	item->prev = item->next = NULL;
+	item->handle = NULL;
+	item->name = NULL;
+	item->mode = NULL;
+	item->read_amount = item->read_no = 0;
+	item->write_amount = item->write_no = 0;
+	item->buffer_mode = -1;
+	item->buffer_size = 0;
+	return item;
+}
+
+at_map_list_item_t *at_map_list_item_new(const char *filename, const char *function, int line)
+{
+	at_map_list_item_t *item = NULL;
+
+	item = (at_map_list_item_t *)at_meta_pool_get(AT_LIST_TYPE_MAP);
+	if(!item) return NULL;
+
+	item->filename = at_meta_intern(filename);
+	item->function = at_meta_intern(function);
+
+	item->line = line;
+	item->id = (map_id_counter++);
+	item->prev = item->next = NULL;
+	item->pointer = NULL;
+	item->size = 0;
+	item->prot = 0;
+	item->flags = 0;
+	item->fd = -1;
+	item->pagesize = 0;
+	return item;
+}
+
+static void at_list_item_set_origin(at_list_item_t *item, const char *filename,
+	const char *function, int line)
+{
+	if(!item) return;
+
+	item->filename = at_meta_intern(filename);
+	item->function = at_meta_intern(function);
+	item->line = line;
+}
+
+static void *at_list_item_key(at_list_item_t *item, at_list_type_t type)
+{
+	if(!item) return NULL;
+
+	if(type == AT_LIST_TYPE_HEAP) return ((at_heap_list_item_t *)item)->pointer;
+	else if(type == AT_LIST_TYPE_FILE) return (void *)(((at_file_list_item_t *)item)->handle);
+	else if(type == AT_LIST_TYPE_MAP) return ((at_map_list_item_t *)item)->pointer;
+
+	return NULL;
+}
+
+/* pointers are hashed into an open addressing table (linear probing)
+   so that looking up an item on "free", "fclose", or "munmap" does not
+   need to walk the whole list */
+static at_index_t *at_index_new(size_t capacity)
+{
+	at_index_t *index = NULL;
+
+	index = (at_index_t *)at_meta_malloc(sizeof(at_index_t));
+	if(!index) return NULL;
+
+	index->slots = (at_list_item_t **)at_meta_calloc(capacity, sizeof(at_list_item_t *));
+
+	if(!(index->slots))
+	{
+		at_meta_free_null(index);
+		return NULL;
+	}
+
+	index->capacity = capacity;
+	index->length = 0;
+	return index;
+}
+
+static void at_index_free(at_index_t **index)
+{
+	if(!index || !(*index)) return;
+	at_meta_free_null((*index)->slots);
+	at_meta_free_null((*index));
+}
+
+static size_t at_index_slot(at_index_t *index, void *key, at_list_type_t type)
+{
+	size_t slot = at_index_hash(key, index->capacity);
+
+	while(index->slots[slot] &&
+	      (at_list_item_key(index->slots[slot], type) != key))
+		slot = ((slot + 1) & (index->capacity - 1));
+
+	return slot;
+}
+
+static void at_index_grow(at_index_t *index, at_list_type_t type)
+{
+	at_list_item_t **slots = index->slots;
+	size_t capacity = index->capacity, i = 0;
+
+	index->slots = (at_list_item_t **)at_meta_calloc((capacity * 2), sizeof(at_list_item_t *));
+
+	if(!(index->slots))
+	{
+		index->slots = slots;
+		return;
+	}
+
+	index->capacity = (capacity * 2);
+
+	for(i = 0; i < capacity; i++)
+	{
+		if(slots[i])
+			index->slots[at_index_slot(index,
+				at_list_item_key(slots[i], type), type)] = slots[i];
+	}
+
+	at_meta_free_null(slots);
+}
+
+static char at_index_insert(at_index_t *index, at_list_item_t *item, at_list_type_t type)
+{
+	void *key = at_list_item_key(item, type);
+	size_t slot = 0;
+
+	if(!index || !key) return (char)1;
+	if(((index->length + 1) * 2) > index->capacity) at_index_grow(index, type);
+	if((index->length + 1) >= index->capacity) return (char)0;
+
+	slot = at_index_slot(index, key, type);
+	if(!(index->slots[slot])) ++(index->length);
+	index->slots[slot] = item;
+	return (char)1;
+}
+
+static at_list_item_t *at_index_find(at_index_t *index, void *key, at_list_type_t type)
+{
+	if(!index || !key) return NULL;
+	return index->slots[at_index_slot(index, key, type)];
+}
+
+static void at_index_erase(at_index_t *index, at_list_item_t *item,
+	void *key, at_list_type_t type)
+{
+	size_t mask = 0, hole = 0, slot = 0, home = 0;
+
+	if(!index || !key) return;
+
+	mask = (index->capacity - 1);
+	hole = at_index_slot(index, key, type);
+	if(index->slots[hole] != item) return;
+
+	index->slots[hole] = NULL;
+	--(index->length);
+	slot = hole;
+
+	/* shift following entries of the probe sequence back into the hole */
+	while(index->slots[(slot = ((slot + 1) & mask))])
+	{
+		home = at_index_hash(at_list_item_key(index->slots[slot], type),
+		                     index->capacity);
+
+		if(((slot - home) & mask) >= ((slot - hole) & mask))
+		{
+			index->slots[hole] = index->slots[slot];
+			index->slots[slot] = NULL;
+			hole = slot;
+		}
+	}
+}
+
+/* an index missing an item would hide it from "at_list_find", so a
+   list whose index can not grow is searched linearly from then on */
+static void at_list_index(at_list_t *list, at_list_item_t *item)
+{
+	if(!list || !(list->index)) return;
+	if(at_index_insert(list->index, item, list->type)) return;
+
+	fprintf(stderr,
+		"[warn] failed to grow the index of %lu items, searching linearly\n",
+		(unsigned long)(list->length));
+	at_index_free(&(list->index));
+}
+
+void at_list_add(at_list_t *list, at_list_item_t *item, at_list_type_t type)
+{
+	at_list_item_t *tmp = NULL;
+
+	if(!item) return;
+
+	if(!list)
+	{
+		list = (at_list_t *)at_meta_malloc(sizeof(at_list_t));
+		list->first = list->last = item;
+		list->length = 1;
+		list->type = type;
+		list->index = NULL;
+	}
+	else
+	{
+		if(!(list->length))
+		{
+			list->first = list->last = item;
+			list->length = 1;
+		}
+		else
+		{
+			tmp = list->last;
+			item->prev = tmp;
+			tmp->next = item;
+			list->last = item;
+			++(list->length);
+		}
+	}
+
+	if((type == AT_LIST_TYPE_HEAP) && !heap_list) heap_list = list;
+	if((type == AT_LIST_TYPE_FILE) && !file_list) file_list = list;
+	if((type == AT_LIST_TYPE_MAP) && !map_list) map_list = list;
+
+	/* only a list holding nothing but the new item starts an index */
+	if(!(list->index) && (list->length == 1)) list->index = at_index_new(AT_INDEX_CAPACITY);
+	at_list_index(list, item);
+
+	at_track_stats_aquire(item, type);
+	can_report = (char)1;
+}
+
+static at_list_item_t *at_list_find(at_list_t *list, void *pointer)
+{
+	at_list_item_t *item = NULL;
+
+	if(!pointer || !list) return NULL;
+	if(!(list->length)) return NULL;
+
+	if(list->index) return at_index_find(list->index, pointer, list->type);
+
+	item = list->first;
+
+	while(item)
+	{
+		if(at_list_item_key(item, list->type) == pointer) return item;
+		item = item->next;
+	}
+
+	return NULL;
+}
+
+at_list_item_t *at_list_get(at_list_t *list, void *pointer)
+{
+	uint64_t start = at_meta_clock();
+	at_list_item_t *item = at_list_find(list, pointer);
+
+	at_meta_time(&(meta_stats.lookup), start);
+	return item;
+}
+
+void at_list_rekey(at_list_t *list, at_list_item_t *item, void *pointer)
+{
+	if(!list || !item || !(list->index)) return;
+	at_index_erase(list->index, item, pointer, list->type);
+	at_list_index(list, item);
+}
+
+static void at_list_unlink(at_list_t *list, at_list_item_t *item)
+{
+	if(item == (at_list_item_t *)leak_cursor)
+		leak_cursor = (at_heap_list_item_t *)(item->next);
+
+	if(item->prev) item->prev->next = item->next;
+	else list->first = item->next;
+	if(item->next) item->next->prev = item->prev;
+	else list->last = item->prev;
+	item->prev = item->next = NULL;
+
+	at_index_erase(list->index, item,
+		at_list_item_key(item, list->type), list->type);
+	--(list->length);
+}
+
+void at_list_remove(at_list_t *list, void *pointer)
+{
+	at_list_item_t *item = NULL;
+
+	if(!pointer || !list) return;
+	if(!(list->length)) return;
+
+	if((item = at_list_get(list, pointer)))
+	{
+		at_list_unlink(list, item);
+		at_track_stats_release(item, list->type);
+		at_list_free_item(&item, list->type);
+	}
+
+	return;
+}
+
+/* releases the block, stream, or mapping an item stands for */
+static void at_list_release_item(at_list_item_t **item, at_list_type_t type)
+{
+	at_heap_list_item_t **heap_item = NULL;
+	at_file_list_item_t **file_item = NULL;
+	at_map_list_item_t **map_item = NULL;
+
+	if(type == AT_LIST_TYPE_HEAP)
+	{
+		heap_item = (at_heap_list_item_t **)item;
+
+		if((*heap_item)->kind != AT_ALLOC_KIND_MALLOC)
+		{
+			/* "new" allocates blocks of 0 bytes as well */
+			free((*heap_item)->pointer);
+			(*heap_item)->pointer = NULL;
+		}
+		else if(((signed long)(*heap_item)->size) <= 0)
+		{
+			fprintf(stderr,
+				"[heap] invalid allocation size of %ld bytes detected\n",
+				((signed long)((*heap_item)->size)));
+		}
+		else if((*heap_item)->pointer)
+		{
+			free((*heap_item)->pointer);
+			(*heap_item)->pointer = NULL;
+		}
+	}
+	else if(type == AT_LIST_TYPE_FILE)
+	{
+		file_item = (at_file_list_item_t **)item;
+		if(((*file_item)->handle)) fclose((*file_item)->handle);
+	}
+	else if(type == AT_LIST_TYPE_MAP)
+	{
+		map_item = (at_map_list_item_t **)item;
+
+		if((*map_item)->pointer && (*map_item)->size)
+			munmap((*map_item)->pointer, (*map_item)->size);
+	}
+}
+
+void at_list_free_item(at_list_item_t **item, at_list_type_t type)
+{
+	if(!item) return;
+	if(!(*item)) return;
+
+	at_list_release_item(item, type);
+
+	if(type == AT_LIST_TYPE_FILE)
+	{
+		at_meta_free_null(((at_file_list_item_t *)(*item))->name);
+		at_meta_free_null(((at_file_list_item_t *)(*item))->mode);
+	}
+
+	at_meta_pool_put(*item, type);
+	*item = NULL;
+}
+
+/* the items are not freed one by one, but along with the chunks of their
+   pool; unless "release" is set the blocks, streams, and mappings they
+   stand for are left to the process exit */
+void at_list_free(at_list_t *list, char release)
+{
+	at_list_item_t *item = NULL;
+
+	if(!list) return;
+
+	/* only released items and the strings of streams need a walk */
+	if(release || (list->type == AT_LIST_TYPE_FILE))
+	{
+		for(item = list->first; item; item = item->next)
+		{
+			if(release) at_list_release_item(&item, list->type);
+
+			if(list->type == AT_LIST_TYPE_FILE)
+			{
+				at_meta_free_null(((at_file_list_item_t *)item)->name);
+				at_meta_free_null(((at_file_list_item_t *)item)->mode);
+			}
+		}
+	}
+
+	at_meta_pool_free(list->type);
+	at_index_free(&(list->index));
+	at_meta_free_null(list);
+}
+
+size_t at_list_length(at_list_t *list)
+{
+	if(!list) return (size_t)0;
+	return list->length;
+}
+
+#define AT_COMPACT_ADDRESS ((((uint64_t)1) << 48) - 1)
+
+static void *at_compact_pointer(const at_compact_record_t *record)
+{
+	return (void *)(uintptr_t)(record->word & AT_COMPACT_ADDRESS);
+}
+
+static size_t at_compact_size(const at_compact_record_t *record)
+{
+	return (size_t)(((record->word >> 48) << 32) | record->size_low);
+}
+
+static at_site_t *at_compact_site(const at_compact_record_t *record)
+{
+	return site_table.sites[(record->site - 1)];
+}
+
+static void at_compact_set(at_compact_record_t *record, void *pointer, size_t size)
+{
+	record->word = ((uint64_t)(uintptr_t)pointer | ((((uint64_t)size) >> 32) << 48));
+	record->size_low = (uint32_t)size;
+}
+
+/* tagged addresses, and sizes beyond 48 bits, are left to a full item */
+static char at_compact_fits(void *pointer, size_t size, at_site_t *site)
+{
+	return (char)(pointer && site && !((uint64_t)(uintptr_t)pointer & ~AT_COMPACT_ADDRESS) &&
+	              !(((uint64_t)size) >> 48) && (compact.length < UINT32_MAX));
+}
+
+static size_t at_compact_slot(void *pointer)
+{
+	size_t slot = at_index_hash(pointer, compact.slot_capacity);
+
+	while(compact.slots[slot] &&
+	      (at_compact_pointer(&(compact.records[(compact.slots[slot] - 1)])) != pointer))
+		slot = ((slot + 1) & (compact.slot_capacity - 1));
+
+	return slot;
+}
+
+/* the position of the live record of "pointer", or -1 */
+static size_t at_compact_find(void *pointer)
+{
+	size_t slot = 0;
+
+	if(!pointer || !(compact.live)) return (size_t)(-1);
+	slot = at_compact_slot(pointer);
+	return (compact.slots[slot] ? (size_t)(compact.slots[slot] - 1) : (size_t)(-1));
+}
+
+static void at_compact_reindex(void)
+{
+	size_t i = 0;
+
+	memset(compact.slots, '\0', (compact.slot_capacity * sizeof(uint32_t)));
+
+	for(i = 0; i < compact.length; i++)
+		if(compact.records[i].word & AT_COMPACT_ADDRESS)
+			compact.slots[at_compact_slot(at_compact_pointer(&(compact.records[i])))] = (uint32_t)(i + 1);
+}
+
+/* as "at_index_erase", the following entries are shifted into the hole */
+static void at_compact_unindex(size_t position)
+{
+	size_t mask = (compact.slot_capacity - 1), hole = 0, slot = 0, home = 0;
+
+	hole = at_compact_slot(at_compact_pointer(&(compact.records[position])));
+	compact.slots[hole] = 0;
+	slot = hole;
+
+	while(compact.slots[(slot = ((slot + 1) & mask))])
+	{
+		home = at_index_hash(at_compact_pointer(&(compact.records[(compact.slots[slot] - 1)])),
+		                     compact.slot_capacity);
+
+		if(((slot - home) & mask) >= ((slot - hole) & mask))
+		{
+			compact.slots[hole] = compact.slots[slot];
+			compact.slots[slot] = 0;
+			hole = slot;
+		}
+	}
+}
+
+/* freed records are squeezed out, the live ones keep allocation order */
+static void at_compact_squeeze(void)
+{
+	size_t i = 0, length = 0;
+
+	for(i = 0; i < compact.length; i++)
+		if(compact.records[i].word & AT_COMPACT_ADDRESS)
+			compact.records[length++] = compact.records[i];
+
+	compact.length = length;
+	++(compact.squeeze_no);
+	at_compact_reindex();
+}
+
+static char at_compact_reserve(void)
+{
+	at_compact_record_t *records = NULL;
+	uint32_t *slots = NULL;
+	size_t capacity = 0;
+
+	if(compact.length == compact.capacity)
+	{
+		capacity = (compact.capacity ? (compact.capacity * 2) : AT_COMPACT_MIN);
+		records = (at_compact_record_t *)at_meta_realloc(compact.records,
+			(capacity * sizeof(at_compact_record_t)));
+		if(!records) return (char)0;
+		compact.records = records;
+		compact.capacity = capacity;
+	}
+
+	if(((compact.live + 1) * 2) > compact.slot_capacity)
+	{
+		capacity = (compact.slot_capacity ? (compact.slot_capacity * 2) : (AT_COMPACT_MIN * 2));
+		if(!(slots = (uint32_t *)at_meta_malloc(capacity * sizeof(uint32_t)))) return (char)0;
+		at_meta_free_null(compact.slots);
+		compact.slots = slots;
+		compact.slot_capacity = capacity;
+		at_compact_reindex();
+	}
+
+	return (char)1;
+}
+
+/* records the block in compact mode, unless it has to take a full item */
+static char at_compact_add(void *pointer, size_t size, at_site_t *site)
+{
+	at_compact_record_t *record = NULL;
+
+	if(!compact_enabled || !at_compact_fits(pointer, size, site) || !at_compact_reserve())
+		return (char)0;
+
+	if(!can_record) at_track_stats_init();
+
+	record = &(compact.records[compact.length]);
+	at_compact_set(record, pointer, size);
+	record->site = (uint32_t)(site->id);
+	compact.slots[at_compact_slot(pointer)] = (uint32_t)(++(compact.length));
+	++(compact.live);
+
+	stats.alloc_amount += size;
+	++(stats.alloc_no);
+	++(site->alloc_no);
+	site->alloc_amount += size;
+	at_site_acquire(site, size);
+	at_class_record(site, size);
+	at_shm_update(site);
+	can_report = (char)1;
+	return (char)1;
+}
+
+/* unless "release" is set the block itself is left alone */
+static void at_compact_remove(size_t position, char release)
+{
+	at_compact_record_t *record = &(compact.records[position]);
+	at_site_t *site = at_compact_site(record);
+	size_t size = at_compact_size(record);
+
+	if(!can_record) at_track_stats_init();
+
+	at_compact_unindex(position);
+	if(release) free(at_compact_pointer(record));
+	record->word = 0;
+	--(compact.live);
+
+	stats.free_amount += size;
+	++(stats.free_no);
+	++(site->free_no);
+	at_site_release(site, size);
+	at_shm_update(NULL);
+
+	if(((compact.length - compact.live) > compact.live) &&
+	   ((compact.length - compact.live) >= AT_COMPACT_MIN))
+		at_compact_squeeze();
+}
+
+/* the block moved, or grew, and belongs to "site" from now on; if it no
+   longer fits a record it is dropped, for the caller to track it again */
+static char at_compact_move(size_t position, void *pointer, size_t size, at_site_t *site)
+{
+	at_compact_record_t *record = &(compact.records[position]);
+
+	if(!at_compact_fits(pointer, size, site))
+	{
+		at_compact_remove(position, (char)0);
+		return (char)0;
+	}
+
+	at_compact_unindex(position);
+	at_site_release(at_compact_site(record), at_compact_size(record));
+	at_site_acquire(site, size);
+	at_compact_set(record, pointer, size);
+	record->site = (uint32_t)(site->id);
+	compact.slots[at_compact_slot(pointer)] = (uint32_t)(position + 1);
+	at_shm_update(site);
+	return (char)1;
+}
+
+static void at_compact_free(char release)
+{
+	size_t i = 0;
+
+	for(i = 0; release && (i < compact.length); i++)
+		if(compact.records[i].word & AT_COMPACT_ADDRESS)
+			free(at_compact_pointer(&(compact.records[i])));
+
+	at_meta_free_null(compact.records);
+	at_meta_free_null(compact.slots);
+	memset(&compact, '\0', sizeof(at_compact_t));
+}
+
+/* blocks allocated while enabled take a 16 byte record instead of a full
+   item, which they keep until freed either way */
+void at_compact_enable(int enable)
+{
+	AT_LOCK();
+	compact_enabled = (char)(enable != 0);
+	AT_UNLOCK();
+}
+
+static void at_file_buffer_describe(at_file_list_item_t *item, char *buffer, size_t length)
+{
+	if(item->buffer_mode == _IONBF)
+		snprintf(buffer, length, "unbuffered");
+	else if(item->buffer_mode == _IOLBF)
+		snprintf(buffer, length, "line buffered (%lu B)", (unsigned long)(item->buffer_size));
+	else if(item->buffer_mode == _IOFBF)
+		snprintf(buffer, length, "fully buffered (%lu B)", (unsigned long)(item->buffer_size));
+	else snprintf(buffer, length, "default buffering");
+}
+
+/* many small transfers only hurt if (nearly) every one of them reaches
+   the kernel, i.e. the stream is unbuffered, line buffered when writing,
+   or its buffer is not larger than the transfers themselves */
+static char at_file_io_tiny(at_file_list_item_t *item, char write)
+{
+	size_t amount = (write ? item->write_amount : item->read_amount);
+	size_t calls = (write ? item->write_no : item->read_no);
+
+	if((calls < AT_IO_TINY_CALLS) || ((amount / calls) >= AT_IO_TINY_SIZE))
+		return (char)0;
+
+	if(item->buffer_mode == _IONBF) return (char)1;
+	if(write && (item->buffer_mode == _IOLBF)) return (char)1;
+	if((item->buffer_mode >= 0) && (item->buffer_size <= AT_IO_TINY_SIZE))
+		return (char)1;
+
+	return (char)0;
+}
+
+static void at_file_io_warn(at_file_list_item_t *item)
+{
+	char buffer[48];
+
+	if(!item) return;
+
+	at_file_buffer_describe(item, buffer, sizeof(buffer));
+
+	if(at_file_io_tiny(item, (char)0))
+		fprintf(stderr,
+			"[file] %lu tiny reads of %lu bytes on average from %s stream %p (%s)\n",
+			(unsigned long)(item->read_no),
+			(unsigned long)(item->read_amount / item->read_no),
+			buffer, (void *)(item->handle),
+			(item->name ? at_basename(item->name) : "temporary file"));
+
+	if(at_file_io_tiny(item, (char)1))
+		fprintf(stderr,
+			"[file] %lu tiny writes of %lu bytes on average to %s stream %p (%s)\n",
+			(unsigned long)(item->write_no),
+			(unsigned long)(item->write_amount / item->write_no),
+			buffer, (void *)(item->handle),
+			(item->name ? at_basename(item->name) : "temporary file"));
+}
+
+static const char *at_fd_type_name(at_fd_type_t type)
+{
+	switch(type)
+	{
+		case AT_FD_TYPE_FILE: return "file";
+		case AT_FD_TYPE_SOCKET: return "socket";
+		case AT_FD_TYPE_PIPE: return "pipe";
+		case AT_FD_TYPE_DUP: return "dup";
+		case AT_FD_TYPE_EVENT: return "eventfd";
+		case AT_FD_TYPE_EPOLL: return "epoll";
+	}
+
+	return "";
+}
+
+/* descriptors are small dense integers, so they index the table directly */
+static void at_fd_release(int fd)
+{
+	at_fd_item_t *item = NULL;
+
+	if(fd < 0) return;
+
+	AT_LOCK();
+
+	if(((size_t)fd < fd_table.capacity) && fd_table.items[fd].open)
+	{
+		item = &(fd_table.items[fd]);
+		at_meta_free_null(item->filename);
+		at_meta_free_null(item->function);
+		item->open = (char)0;
+		--(fd_table.length);
+
+		if(!can_record) at_track_stats_init();
+		++(fd_stats.close_no);
+	}
+
+	AT_UNLOCK();
+}
+
+static int at_fd_track(int fd, at_fd_type_t type, const char *filename,
+	const char *function, int line)
+{
+	at_fd_item_t *items = NULL;
+	size_t capacity = 0;
+
+	if(fd < 0) return fd;
+
+	AT_LOCK();
+
+	if((size_t)fd >= fd_table.capacity)
+	{
+		capacity = (fd_table.capacity ? fd_table.capacity : AT_FD_CAPACITY);
+		while(capacity <= (size_t)fd) capacity *= 2;
+
+		items = (at_fd_item_t *)at_meta_realloc(fd_table.items, (capacity * sizeof(at_fd_item_t)));
+
+		if(!items)
+		{
+			AT_UNLOCK();
+			return fd;
+		}
+
+		memset(&items[fd_table.capacity], '\0',
+		       ((capacity - fd_table.capacity) * sizeof(at_fd_item_t)));
+		fd_table.items = items;
+		fd_table.capacity = capacity;
+	}
+
+	/* a stale entry means the descriptor was closed behind our back */
+	at_fd_release(fd);
+
+	fd_table.items[fd].id = (fd_id_counter++);
+	fd_table.items[fd].type = type;
+	fd_table.items[fd].line = line;
+	fd_table.items[fd].open = (char)1;
+
+	if(filename)
+	{
+		fd_table.items[fd].filename = (char *)at_meta_malloc((strlen(filename) + 1) * sizeof(char));
+		strcpy(fd_table.items[fd].filename, filename);
+	}
+	else fd_table.items[fd].filename = NULL;
+
+	if(function)
+	{
+		fd_table.items[fd].function = (char *)at_meta_malloc((strlen(function) + 1) * sizeof(char));
+		strcpy(fd_table.items[fd].function, function);
+	}
+	else fd_table.items[fd].function = NULL;
+
+	++(fd_table.length);
+
+	if(!can_record) at_track_stats_init();
+	++(fd_stats.open_no);
+	if(fd_table.length > fd_stats.peak_no) fd_stats.peak_no = fd_table.length;
+
+	can_report = (char)1;
+	AT_UNLOCK();
+	return fd;
+}
+
+int at_fd_query(int fd)
+{
+	int type = -1;
+
+	if(fd < 0) return -1;
+	AT_LOCK();
+
+	if(((size_t)fd < fd_table.capacity) && fd_table.items[fd].open)
+		type = (int)(fd_table.items[fd].type);
+
+	AT_UNLOCK();
+	return type;
+}
+
+/* the descriptors are closed only when "release" is set, otherwise they
+   stay with the application and only the metadata is freed */
+static void at_fd_table_free(char release)
+{
+	size_t fd = 0;
+
+	for(fd = 0; fd < fd_table.capacity; fd++)
+	{
+		if(!(fd_table.items[fd].open)) continue;
+		if(release) close((int)fd);
+		at_meta_free_null(fd_table.items[fd].filename);
+		at_meta_free_null(fd_table.items[fd].function);
+	}
+
+	at_meta_free_null(fd_table.items);
+	fd_table.capacity = fd_table.length = 0;
+}
+
+/* without a call site (see AT_NEW_TRACK) "new" is attributed to the
+   function calling it, the line being the offset of the call into that
+   function; demangling is available whenever the C++ runtime is linked */
+extern char *__cxa_demangle(const char *, char *, size_t *, int *) __attribute__((weak));
+
+static at_caller_t *at_caller_resolve(void *address)
+{
+	at_caller_t *caller = &(caller_cache[at_index_hash(address, AT_CALLER_CACHE)]);
+	Dl_info info;
+	char *name = NULL;
+	int status = -1;
+
+	if(caller->address == address) return caller;
+
+	at_meta_free_null(caller->filename);
+	at_meta_free_null(caller->function);
+	caller->address = address;
+	caller->line = 0;
+
+	if(!dladdr(address, &info)) return caller;
+	if(info.dli_fname) caller->filename = at_meta_strdup(info.dli_fname);
+
+	if(info.dli_sname)
+	{
+		if(__cxa_demangle) name = __cxa_demangle(info.dli_sname, NULL, NULL, &status);
+		/* the demangled name comes from the plain allocator */
+		caller->function = at_meta_strdup((name && !status) ? name : info.dli_sname);
+		if(name) free(name);
+		if(strchr(caller->function, '(')) *strchr(caller->function, '(') = '\0';
+		caller->line = (int)((char *)address - (char *)(info.dli_saddr));
+	}
+	else caller->line = (int)((char *)address - (char *)(info.dli_fbase));
+
+	return caller;
+}
+
+static void at_caller_cache_free(void)
+{
+	size_t i = 0;
+
+	for(i = 0; i < AT_CALLER_CACHE; i++)
+	{
+		at_meta_free_null(caller_cache[i].filename);
+		at_meta_free_null(caller_cache[i].function);
+		caller_cache[i].address = NULL;
+	}
+}
+
+#define at_arena_round(S) ((((S) + AT_ARENA_ALIGNMENT - 1) / AT_ARENA_ALIGNMENT) * AT_ARENA_ALIGNMENT)
+
+/* arenas hand out memory by bumping an offset into large chunks and
+   release it all at once; the tracker keeps every arena in a list of
+   its own, so arenas show up in the report next to the heap */
+at_arena_t *at_arena_create(const char *name, size_t capacity)
+{
+	at_arena_t *arena = (at_arena_t *)at_meta_calloc(1, sizeof(at_arena_t));
+
+	if(!arena) return NULL;
+
+	if(name)
+	{
+		arena->name = (char *)at_meta_malloc((strlen(name) + 1) * sizeof(char));
+		if(arena->name) strcpy(arena->name, name);
+	}
+
+	arena->capacity = (capacity ? capacity : AT_ARENA_CAPACITY);
+
+	AT_LOCK();
+	arena->id = (arena_id_counter++);
+	arena->next = arena_list;
+	if(arena_list) arena_list->prev = arena;
+	arena_list = arena;
+	AT_UNLOCK();
+
+	return arena;
+}
+
+static at_arena_chunk_t *at_arena_chunk_new(at_arena_t *arena, size_t size)
+{
+	at_arena_chunk_t *chunk = NULL;
+
+	if(size < arena->capacity) size = arena->capacity;
+	chunk = (at_arena_chunk_t *)malloc(at_arena_round(sizeof(at_arena_chunk_t)) + size);
+	if(!chunk) return NULL;
+
+	chunk->next = NULL;
+	chunk->size = size;
+	chunk->used = 0;
+
+	if(arena->last) arena->last->next = chunk;
+	else arena->first = chunk;
+
+	arena->last = chunk;
+	arena->reserved += size;
+	return chunk;
+}
+
+/* an arena is not locked, it must not be shared between threads
+   without synchronization */
+void *at_arena_alloc(at_arena_t *arena, size_t size)
+{
+	at_arena_chunk_t *chunk = NULL;
+	void *pointer = NULL;
+
+	if(!arena || arena->destroyed) return NULL;
+	size = at_arena_round(size ? size : 1);
+
+	for(chunk = arena->current; chunk && ((chunk->used + size) > chunk->size); chunk = chunk->next);
+	if(!chunk && !(chunk = at_arena_chunk_new(arena, size))) return NULL;
+
+	arena->current = chunk;
+	pointer = ((char *)chunk + at_arena_round(sizeof(at_arena_chunk_t)) + chunk->used);
+	chunk->used += size;
+	arena->used += size;
+	++(arena->alloc_no);
+	if(arena->used > arena->peak) arena->peak = arena->used;
+	return pointer;
+}
+
+void at_arena_reset(at_arena_t *arena)
+{
+	at_arena_chunk_t *chunk = NULL;
+
+	if(!arena || arena->destroyed) return;
+	for(chunk = arena->first; chunk; chunk = chunk->next) chunk->used = 0;
+
+	arena->current = arena->first;
+	arena->used = 0;
+	++(arena->reset_no);
+}
+
+static void at_arena_release(at_arena_t *arena)
+{
+	at_arena_chunk_t *chunk = NULL;
+
+	while((chunk = arena->first))
+	{
+		arena->first = chunk->next;
+		free(chunk);
+	}
+
+	arena->current = arena->last = NULL;
+	arena->used = arena->reserved = 0;
+}
+
+/* the chunks are released right away, the statistics of the arena
+   are kept for the report until "at_free_all" */
+void at_arena_destroy(at_arena_t *arena)
+{
+	if(!arena) return;
+	AT_LOCK();
+	at_arena_release(arena);
+	arena->destroyed = (char)1;
+	AT_UNLOCK();
+}
+
+/* the handles of arenas still alive are held by the application, so
+   only their chunks are released; they are marked destroyed, which
+   makes any later call on them fail or do nothing, and are kept apart
+   from the reported arenas until the exit */
+static void at_arena_free_all(void)
+{
+	at_arena_t *arena = NULL;
+
+	while((arena = arena_list))
+	{
+		arena_list = arena->next;
+		at_arena_release(arena);
+		at_meta_free_null(arena->name);
+
+		if(arena->destroyed)
+		{
+			at_meta_free(arena);
+			continue;
+		}
+
+		arena->destroyed = (char)1;
+		arena->prev = NULL;
+		arena->next = arena_orphans;
+		arena_orphans = arena;
+	}
+}
+
+static void at_teardown(char release)
+{
+	at_list_free(heap_list, release);
+	at_list_free(file_list, release);
+	at_list_free(map_list, release);
+	heap_list = file_list = map_list = NULL;
+	at_compact_free(release);
+	leak_cursor = NULL;
+	leak_scanning = (char)0;
+	leak_pass_no = 0;
+	at_meta_strings_free();
+	/* blocks left to the process exit may still be deleted */
+	if(!release) new_orphans = (char)1;
+	at_fd_table_free(release);
+	at_site_table_free();
+	at_scope_table_free();
+	at_budget_free();
+	at_arena_free_all();
+	at_caller_cache_free();
+	at_meta_free_null(line_owners);
+	at_shm_release();
+	can_report = (char)0;
+}
+
+void at_free_all(void)
+{
+	at_dump_stop();
+	AT_LOCK();
+	at_teardown((char)1);
+	AT_UNLOCK();
+}
+
+static void at_report_threads(void)
+{
+	at_site_t *site = NULL;
+	size_t i = 0, j = 0, flagged = 0;
+	char *source = NULL, *func = NULL;
+
+	for(i = 0; i < site_table.length; i++)
+	{
+		site = site_table.sites[i];
+		if(!(site->remote_free_no) && !(site->remote_realloc_no)) continue;
+
+		if(!(flagged++)) fprintf(stderr, "cross-thread frees:\n");
+
+		source = at_truncate(at_basename(site->filename), 20);
+		func = at_truncate(site->function, 20);
+
+		fprintf(stderr,
+			"  %20s:%-4d  %-22s  %lu of %lu frees remote (%lu%%), %lu resized remotely, threads",
+			source, site->line, func, (unsigned long)(site->remote_free_no),
+			(unsigned long)(site->free_no),
+			(unsigned long)((site->remote_free_no * 100) / (site->free_no ? site->free_no : 1)),
+			(unsigned long)(site->remote_realloc_no));
+
+		for(j = 0; (j < AT_SITE_THREAD_PAIRS) && site->pairs[j].count; j++)
+			fprintf(stderr, " %lu->%lu (%lu)", (unsigned long)(site->pairs[j].producer),
+			        (unsigned long)(site->pairs[j].consumer),
+			        (unsigned long)(site->pairs[j].count));
+
+		if(site->pairs_other)
+			fprintf(stderr, " others (%lu)", (unsigned long)(site->pairs_other));
+
+		fprintf(stderr, "\n");
+		at_meta_free_null(source);
+		at_meta_free_null(func);
+	}
+
+	if(flagged) fprintf(stderr, "\n");
+}
+
+static int at_heap_item_compare(const void *a, const void *b)
+{
+	const at_heap_list_item_t *x = *(at_heap_list_item_t * const *)a;
+	const at_heap_list_item_t *y = *(at_heap_list_item_t * const *)b;
+
+	if((uintptr_t)(x->pointer) < (uintptr_t)(y->pointer)) return -1;
+	return ((uintptr_t)(x->pointer) > (uintptr_t)(y->pointer));
+}
+
+static void at_sharing_record(at_heap_list_item_t *x, at_heap_list_item_t *y)
+{
+	if(!(x->site->shared_no++))
+	{
+		x->site->shared_site = y->site;
+		x->site->shared_threads[0] = x->thread;
+		x->site->shared_threads[1] = y->thread;
+	}
+}
+
+/* small live blocks of different threads sharing a cache line are likely
+   to suffer from false sharing; the blocks are sorted by address, so all
+   blocks touching the lines of a block directly follow it */
+static void at_report_sharing(void)
+{
+	at_heap_list_item_t **blocks = NULL, *item = NULL;
+	at_site_t *site = NULL;
+	size_t length = 0, i = 0, j = 0, flagged = 0;
+	char *source = NULL, *func = NULL, *other = NULL;
+
+	for(i = 0; i < site_table.length; i++) site_table.sites[i]->shared_no = 0;
+
+	if(at_list_length(heap_list))
+		blocks = (at_heap_list_item_t **)at_meta_malloc(heap_list->length * sizeof(at_heap_list_item_t *));
+
+	for(item = (blocks ? (at_heap_list_item_t *)(heap_list->first) : NULL); item; item = item->next)
+	{
+		if(item->pointer && item->site && at_heap_item_size(item) &&
+		   (at_heap_item_size(item) <= AT_SHARING_SIZE))
+			blocks[length++] = item;
+	}
+
+	if(length) qsort(blocks, length, sizeof(at_heap_list_item_t *), at_heap_item_compare);
+
+	for(i = 0; i < length; i++)
+	{
+		for(j = (i + 1); j < length; j++)
+		{
+			if(((size_t)(blocks[j]->pointer) / AT_CACHE_LINE) >
+			   (((size_t)(blocks[i]->pointer) + at_heap_item_size(blocks[i]) - 1) / AT_CACHE_LINE))
+				break;
+
+			if(blocks[i]->thread == blocks[j]->thread) continue;
+
+			at_sharing_record(blocks[i], blocks[j]);
+			if(blocks[j]->site != blocks[i]->site) at_sharing_record(blocks[j], blocks[i]);
+		}
+	}
+
+	at_meta_free_null(blocks);
+
+	for(i = 0; i < site_table.length; i++)
+	{
+		site = site_table.sites[i];
+		if(!(site->shared_no) && !(site->reuse_no)) continue;
+
+		if(!(flagged++)) fprintf(stderr, "false sharing risks:\n");
+
+		source = at_truncate(at_basename(site->filename), 20);
+		func = at_truncate(site->function, 20);
+		fprintf(stderr, "  %20s:%-4d  %-22s", source, site->line, func);
+		at_meta_free_null(source);
+		at_meta_free_null(func);
+
+		if(site->shared_no)
+		{
+			other = at_truncate(at_basename(site->shared_site->filename), 20);
+			fprintf(stderr, "  %lu line%s shared with %s:%d (threads %lu, %lu)",
+				(unsigned long)(site->shared_no), ((site->shared_no == 1) ? "" : "s"),
+				other, site->shared_site->line,
+				(unsigned long)(site->shared_threads[0]),
+				(unsigned long)(site->shared_threads[1]));
+			at_meta_free_null(other);
+		}
+
+		if(site->reuse_no)
+		{
+			other = at_truncate(at_basename(site->reuse_site->filename), 20);
+			fprintf(stderr, "  %lu line%s taken over from %s:%d",
+				(unsigned long)(site->reuse_no), ((site->reuse_no == 1) ? "" : "s"),
+				other, site->reuse_site->line);
+			at_meta_free_null(other);
+		}
+
+		fprintf(stderr, "\n");
+	}
+
+	if(flagged)
+		fprintf(stderr,
+			"\n  pad, or align, blocks of these sites to %d bytes\n\n", AT_CACHE_LINE);
+}
+
+static void at_report_scopes(void)
+{
+	at_scope_t *scope = NULL;
+	size_t i = 0;
+	char *tag = NULL;
+
+	if(!scope_table.length) return;
+	fprintf(stderr, "allocations per scope:\n");
+
+	for(i = 0; i < scope_table.length; i++)
+	{
+		scope = scope_table.scopes[i];
+		tag = at_truncate(scope->tag, 24);
+
+		fprintf(stderr,
+			"  %-24s  %8lu allocations  %10lu bytes  live %10lu  peak %10lu\n",
+			tag, (unsigned long)(scope->alloc_no), (unsigned long)(scope->alloc_amount),
+			(unsigned long)(scope->live_amount), (unsigned long)(scope->peak_amount));
+
+		at_meta_free_null(tag);
+	}
+
+	fprintf(stderr, "\n");
+}
+
+/* the contents are hashed in four independent lanes of eight bytes each,
+   which the compiler can keep in vector registers */
+static uint64_t at_dup_hash(const unsigned char *data, size_t length)
+{
+	uint64_t lanes[4] = { 0x9e3779b97f4a7c15ULL, 0xc2b2ae3d27d4eb4fULL,
+	                      0x165667b19e3779f9ULL, 0x27d4eb2f165667c5ULL };
+	uint64_t words[4], hash = (uint64_t)length;
+	size_t i = 0, j = 0;
+
+	for(; (i + sizeof(words)) <= length; i += sizeof(words))
+	{
+		memcpy(words, (data + i), sizeof(words));
+		for(j = 0; j < 4; j++) lanes[j] = ((lanes[j] ^ words[j]) * 0x100000001b3ULL);
+	}
+
+	for(j = 0; j < 4; j++) hash = ((hash ^ (lanes[j] >> 29) ^ lanes[j]) * 0x9e3779b97f4a7c15ULL);
+	for(; i < length; i++) hash = ((hash ^ data[i]) * 0x100000001b3ULL);
+	return (hash ^ (hash >> 32));
+}
+
+static int at_dup_entry_compare(const void *a, const void *b)
+{
+	const at_dup_entry_t *x = (const at_dup_entry_t *)a;
+	const at_dup_entry_t *y = (const at_dup_entry_t *)b;
+
+	if(x->item->size != y->item->size) return ((x->item->size < y->item->size) ? -1 : 1);
+	if(x->hash != y->hash) return ((x->hash < y->hash) ? -1 : 1);
+	if(x->item->id != y->item->id) return ((x->item->id < y->item->id) ? -1 : 1);
+	return 0;
+}
+
+static int at_dup_site_compare(const void *a, const void *b)
+{
+	const at_site_t *x = *(const at_site_t * const *)a;
+	const at_site_t *y = *(const at_site_t * const *)b;
+
+	if(x->dup_amount > y->dup_amount) return -1;
+	return (x->dup_amount < y->dup_amount);
+}
+
+/* enables the duplicate report for blocks of up to "size" bytes */
+void at_dup_enable(size_t size)
+{
+	AT_LOCK();
+	dup_size = size;
+	AT_UNLOCK();
+}
+
+/* within a run of blocks of equal size and hash, every block identical to
+   an older one is a copy, which interning would have saved; the copies are
+   counted into their sites, and the bytes they take into "saved" */
+static size_t at_dup_count(size_t *saved)
+{
+	at_heap_list_item_t *item = NULL;
+	at_dup_entry_t *entries = NULL;
+	at_site_t *site = NULL;
+	size_t length = 0, i = 0, j = 0, k = 0, m = 0, copies = 0;
+
+	*saved = 0;
+
+	for(i = 0; i < site_table.length; i++)
+		site_table.sites[i]->dup_no = site_table.sites[i]->dup_amount = 0;
+
+	if(!dup_size || !heap_list || !(heap_list->length)) return 0;
+	if(!(entries = (at_dup_entry_t *)at_meta_malloc(heap_list->length * sizeof(at_dup_entry_t)))) return 0;
+
+	for(item = (at_heap_list_item_t *)(heap_list->first); item; item = item->next)
+	{
+		if(!(item->pointer) || (item->size <= 0) || ((size_t)(item->size) > dup_size)) continue;
+		entries[length].hash = at_dup_hash((const unsigned char *)(item->pointer), (size_t)(item->size));
+		entries[length].copy = (char)0;
+		entries[length++].item = item;
+	}
+
+	qsort(entries, length, sizeof(at_dup_entry_t), at_dup_entry_compare);
+
+	for(i = 0; i < length; i = j)
+	{
+		for(j = (i + 1); (j < length) && (entries[j].hash == entries[i].hash) &&
+		    (entries[j].item->size == entries[i].item->size); j++);
+
+		/* a block is compared with the older originals of its run, blocks
+		   that merely share their hash are originals of their own */
+		for(k = (i + 1); k < j; k++)
+		{
+			for(m = i; m < k; m++)
+				if(!(entries[m].copy) && !memcmp(entries[m].item->pointer,
+				   entries[k].item->pointer, (size_t)(entries[k].item->size)))
+					break;
+
+			if(m == k) continue;
+
+			entries[k].copy = (char)1;
+			++copies;
+			*saved += (size_t)(entries[k].item->size);
+			if(!(site = entries[k].item->site)) continue;
+			++(site->dup_no);
+			site->dup_amount += (size_t)(entries[k].item->size);
+		}
+	}
+
+	at_meta_free_null(entries);
+	return copies;
+}
+
+/* counts the copies right away, for "at_site_query"; returns their number */
+int at_dup_scan(void)
+{
+	size_t copies = 0, saved = 0;
+
+	AT_LOCK();
+	copies = at_dup_count(&saved);
+	AT_UNLOCK();
+	return (int)copies;
+}
+
+static void at_report_duplicates(void)
+{
+	at_site_t **sites = NULL;
+	size_t i = 0, copies = 0, saved = 0, count = 0;
+	char *source = NULL, *func = NULL;
+
+	if(!(copies = at_dup_count(&saved))) return;
+
+	for(i = 0; i < site_table.length; i++)
+		if(site_table.sites[i]->dup_no) ++count;
+
+	fprintf(stderr, "duplicate contents in blocks of up to %lu bytes:\n", (unsigned long)dup_size);
+
+	if(count && (sites = (at_site_t **)at_meta_malloc(count * sizeof(at_site_t *))))
+	{
+		for(i = 0, count = 0; i < site_table.length; i++)
+			if(site_table.sites[i]->dup_no) sites[count++] = site_table.sites[i];
+
+		qsort(sites, count, sizeof(at_site_t *), at_dup_site_compare);
+
+		for(i = 0; i < count; i++)
+		{
+			source = at_truncate(at_basename(sites[i]->filename), 20);
+			func = at_truncate(sites[i]->function, 20);
+
+			fprintf(stderr,
+			        "  %20s:%-4d  %-22s  %lu of %lu live blocks are copies, %lu bytes saved\n",
+			        source, sites[i]->line, func, (unsigned long)(sites[i]->dup_no),
+			        (unsigned long)(sites[i]->live_no), (unsigned long)(sites[i]->dup_amount));
+
+			at_meta_free_null(source);
+			at_meta_free_null(func);
+		}
+
+		at_meta_free_null(sites);
+	}
+
+	fprintf(stderr, "\n  overall %lu cop%s, %lu byte%s saved by interning\n\n",
+	        (unsigned long)copies, ((copies == 1) ? "y" : "ies"),
+	        (unsigned long)saved, ((saved == 1) ? "" : "s"));
+}
+
+/* reports how much of the blocks of at least "size" bytes is in use */
+void at_unused_enable(size_t size)
+{
+	AT_LOCK();
+	unused_size = size;
+	AT_UNLOCK();
+}
+
+/* the bytes of a block in use: pages never touched are not resident, and
+   the zero tail of the last resident page written to is taken for never
+   used; pages not resident are not read, which would fault them in; both
+   only hold for blocks which started out zero, see "at_unused_record" */
+static size_t at_unused_measure(void *pointer, size_t size)
+{
+	unsigned char *vector = NULL;
+	uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE), start = (uintptr_t)pointer;
+	uintptr_t base = (start & ~(page - 1)), end = (start + size), used = 0, from = 0, to = 0;
+	size_t pages = ((((end + page - 1) & ~(page - 1)) - base) / page), i = 0, length = 0;
+
+	if(!(vector = (unsigned char *)at_meta_malloc(pages))) return size;
+
+	if(mincore((void *)base, (pages * page), vector) != 0)
+	{
+		at_meta_free_null(vector);
+		return size;
+	}
+
+	for(i = pages; (i > 0) && !used; i--)
+	{
+		if(!(vector[(i - 1)] & 1)) continue;
+		from = (((base + ((i - 1) * page)) > start) ? (base + ((i - 1) * page)) : start);
+		to = (((base + (i * page)) < end) ? (base + (i * page)) : end);
+
+		for(; to > from; to--)
+		{
+			if(!(*((const unsigned char *)(to - 1)))) continue;
+			used = to;
+			break;
+		}
+	}
+
+	for(i = 0; used && (i < pages); i++)
+	{
+		if(!(vector[i] & 1)) continue;
+		from = (((base + (i * page)) > start) ? (base + (i * page)) : start);
+		to = (((base + ((i + 1) * page)) < used) ? (base + ((i + 1) * page)) : used);
+		if(to > from) length += (to - from);
+	}
+
+	at_meta_free_null(vector);
+	return length;
+}
+
+/* only blocks mapped on their own, whose pages come zero and untouched
+   from the kernel, and blocks allocated with "calloc" are measured; the
+   contents of others tell nothing of their use */
+static void at_unused_record(at_site_t *site, void *pointer, size_t size, char zeroed)
+{
+	uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+
+	if(!site || !pointer || (size < unused_size)) return;
+	if(!zeroed && ((size < AT_UNUSED_MIN_MAP) ||
+	   (((uintptr_t)pointer & (page - 1)) > AT_UNUSED_HEAD))) return;
+
+	++(site->unused_no);
+	site->unused_reserved += size;
+	site->unused_used += at_unused_measure(pointer, size);
+}
+
+static int at_unused_site_compare(const void *a, const void *b)
+{
+	const at_site_t *x = *(const at_site_t * const *)a;
+	const at_site_t *y = *(const at_site_t * const *)b;
+	size_t m = (x->unused_reserved - x->unused_used), n = (y->unused_reserved - y->unused_used);
+
+	if(m > n) return -1;
+	return (m < n);
+}
+
+/* measures the blocks into their sites, returns the number measured */
+static size_t at_unused_count(void)
+{
+	at_heap_list_item_t *item = NULL;
+	size_t i = 0, count = 0;
+
+	for(i = 0; i < site_table.length; i++)
+		site_table.sites[i]->unused_no = site_table.sites[i]->unused_reserved =
+			site_table.sites[i]->unused_used = 0;
+
+	if(!unused_size) return 0;
+
+	/* compact records do not tell whether their blocks were zeroed */
+	for(item = (heap_list ? (at_heap_list_item_t *)(heap_list->first) : NULL); item; item = item->next)
+		if(item->size > 0)
+			at_unused_record(item->site, item->pointer, (size_t)(item->size), item->zeroed);
+
+	for(i = 0; i < compact.length; i++)
+		if(compact.records[i].word & AT_COMPACT_ADDRESS)
+			at_unused_record(at_compact_site(&(compact.records[i])),
+			                 at_compact_pointer(&(compact.records[i])),
+			                 at_compact_size(&(compact.records[i])), (char)0);
+
+	for(i = 0; i < site_table.length; i++) count += site_table.sites[i]->unused_no;
+	return count;
+}
+
+/* measures the blocks right away, for "at_site_query"; returns their number */
+int at_unused_scan(void)
+{
+	size_t count = 0;
+
+	AT_LOCK();
+	count = at_unused_count();
+	AT_UNLOCK();
+	return (int)count;
+}
+
+static void at_report_unused(void)
+{
+	at_site_t **sites = NULL;
+	size_t i = 0, length = 0, reserved = 0, used = 0;
+	char *source = NULL, *func = NULL;
+
+	if(!at_unused_count()) return;
+
+	for(i = 0; i < site_table.length; i++)
+	{
+		reserved += site_table.sites[i]->unused_reserved;
+		used += site_table.sites[i]->unused_used;
+		length += (site_table.sites[i]->unused_used < site_table.sites[i]->unused_reserved);
+	}
+
+	if(!length || !(sites = (at_site_t **)at_meta_malloc(length * sizeof(at_site_t *)))) return;
+
+	for(i = 0, length = 0; i < site_table.length; i++)
+		if(site_table.sites[i]->unused_used < site_table.sites[i]->unused_reserved)
+			sites[length++] = site_table.sites[i];
+
+	qsort(sites, length, sizeof(at_site_t *), at_unused_site_compare);
+	fprintf(stderr, "unused capacity in blocks of at least %lu bytes:\n", (unsigned long)unused_size);
+
+	for(i = 0; i < length; i++)
+	{
+		source = at_truncate(at_basename(sites[i]->filename), 20);
+		func = at_truncate(sites[i]->function, 20);
+
+		fprintf(stderr, "  %20s:%-4d  %-22s  reserves %lu bytes in %lu block%s, %.1f%% used\n",
+		        source, sites[i]->line, func, (unsigned long)(sites[i]->unused_reserved),
+		        (unsigned long)(sites[i]->unused_no), ((sites[i]->unused_no == 1) ? "" : "s"),
+		        ((100.0 * (double)(sites[i]->unused_used)) / (double)(sites[i]->unused_reserved)));
+
+		at_meta_free_null(source);
+		at_meta_free_null(func);
+	}
+
+	fprintf(stderr, "\n  overall %lu of %lu byte%s never used\n\n", (unsigned long)(reserved - used),
+	        (unsigned long)reserved, ((reserved == 1) ? "" : "s"));
+	at_meta_free_null(sites);
+}
+
+static int at_pool_site_compare(const void *a, const void *b)
+{
+	const at_site_t *x = *(const at_site_t * const *)a;
+	const at_site_t *y = *(const at_site_t * const *)b;
+
+	if(x->alloc_no > y->alloc_no) return -1;
+	return (x->alloc_no < y->alloc_no);
+}
+
+static void at_json_string(FILE *stream, const char *string)
+{
+	fputc('"', stream);
+
+	for(; string && *string; string++)
+	{
+		if((*string == '"') || (*string == '\\')) fprintf(stream, "\\%c", *string);
+		else if((unsigned char)(*string) < 0x20) fprintf(stream, "\\u%04x", (unsigned int)(*string));
+		else fputc(*string, stream);
+	}
+
+	fputc('"', stream);
+}
+
+/* bytes wasted when the requests of granules (from, to] are served by a
+   class of the size of granule "to" */
+static size_t at_class_waste(const size_t *counts, const size_t *amounts, const size_t *granules,
+	size_t from, size_t to)
+{
+	return ((counts[to] - counts[from]) * granules[to] * AT_CLASS_GRANULE) -
+	       (amounts[to] - amounts[from]);
+}
+
+/* the classes are chosen among the granules in use by dynamic programming
+   over the prefix sums, the largest class being the smallest size that
+   covers AT_CLASS_COVERAGE percent of all allocations */
+static void at_recommend_classes(FILE *stream, size_t total)
+{
+	size_t granules[(AT_CLASS_GRANULES + 1)], counts[(AT_CLASS_GRANULES + 1)];
+	size_t amounts[(AT_CLASS_GRANULES + 1)], classes[AT_CLASS_COUNT];
+	size_t *cost = NULL, *choice = NULL, length = 0, top = 0, limit = 0;
+	size_t i = 0, j = 0, k = 0, m = 0, waste = 0;
+
+	counts[0] = amounts[0] = 0;
+
+	for(i = 0; i < AT_CLASS_GRANULES; i++)
+	{
+		if(!(class_counts[i])) continue;
+		granules[length] = i;
+		counts[(length + 1)] = counts[length] + class_counts[i];
+		amounts[(length + 1)] = amounts[length] + class_amounts[i];
+		++length;
+	}
+
+	/* the prefix arrays are indexed one past the granule list */
+	for(i = length; i > 0; i--) granules[i] = granules[(i - 1)];
+
+	for(top = 1; (top < length) && ((counts[top] * 100) < (total * AT_CLASS_COVERAGE)); top++);
+	if(top > length) top = length;
+	limit = ((top < AT_CLASS_COUNT) ? top : AT_CLASS_COUNT);
+
+	fprintf(stream, "  \"size_classes\": [");
+
+	if(top && (cost = (size_t *)at_meta_malloc(((limit + 1) * (top + 1)) * sizeof(size_t))) &&
+	   (choice = (size_t *)at_meta_malloc(((limit + 1) * (top + 1)) * sizeof(size_t))))
+	{
+		/* cost[k][j] is the least waste of serving the first j granules
+		   in use with k classes, the k-th one ending at granule j */
+		for(j = 1; j <= top; j++)
+		{
+			cost[((1 * (top + 1)) + j)] = at_class_waste(counts, amounts, granules, 0, j);
+			choice[((1 * (top + 1)) + j)] = 0;
+		}
+
+		for(k = 2; k <= limit; k++)
+		{
+			for(j = k; j <= top; j++)
+			{
+				cost[((k * (top + 1)) + j)] = SIZE_MAX;
+
+				for(i = (k - 1); i < j; i++)
+				{
+					waste = cost[(((k - 1) * (top + 1)) + i)] +
+					        at_class_waste(counts, amounts, granules, i, j);
+					if(waste >= cost[((k * (top + 1)) + j)]) continue;
+					cost[((k * (top + 1)) + j)] = waste;
+					choice[((k * (top + 1)) + j)] = i;
+				}
+			}
+		}
+
+		waste = cost[((limit * (top + 1)) + top)];
+
+		for(k = limit, j = top; k > 0; k--)
+		{
+			classes[(k - 1)] = j;
+			j = choice[((k * (top + 1)) + j)];
+		}
+
+		for(k = 0, j = 0; k < limit; k++)
+		{
+			m = classes[k];
+			fprintf(stream, "%s\n    { \"size\": %lu, \"allocations\": %lu, \"waste\": %lu }",
+			        (k ? "," : ""), (unsigned long)(granules[m] * AT_CLASS_GRANULE),
+			        (unsigned long)(counts[m] - counts[j]),
+			        (unsigned long)at_class_waste(counts, amounts, granules, j, m));
+			j = m;
+		}
+
+		fprintf(stream, "\n  ],\n  \"rounding_waste\": %lu,\n  \"covered\": %lu\n",
+		        (unsigned long)waste, (unsigned long)(counts[top]));
+	}
+	else fprintf(stream, "],\n  \"rounding_waste\": 0,\n  \"covered\": 0\n");
+
+	at_meta_free_null(cost);
+	at_meta_free_null(choice);
+}
+
+/* writes the pools and size classes worth creating as JSON to "path", or
+   to stderr without one */
+int at_recommend(const char *path)
+{
+	FILE *stream = stderr;
+	at_site_t **sites = NULL, *site = NULL;
+	size_t total = class_large_no, length = 0, slabs = 0, i = 0;
+
+	if(path && !(stream = fopen(path, "w")))
+	{
+		fprintf(stderr, "[recommend] failed to open \"%s\"\n", path);
+		return -1;
+	}
+
+	AT_LOCK();
+
+	for(i = 0; i < AT_CLASS_GRANULES; i++) total += class_counts[i];
+
+	if(site_table.length)
+		sites = (at_site_t **)at_meta_malloc(site_table.length * sizeof(at_site_t *));
+
+	/* a site qualifies for a pool if it allocates often and nearly always
+	   the same size, the hits being a lower bound of its true share */
+	for(i = 0; sites && (i < site_table.length); i++)
+	{
+		site = site_table.sites[i];
+		if((site->alloc_no < AT_POOL_MIN_ALLOCS) ||
+		   ((site->size_hits * 100) < (site->alloc_no * AT_POOL_HIT_RATE))) continue;
+		sites[length++] = site;
+	}
+
+	if(length) qsort(sites, length, sizeof(at_site_t *), at_pool_site_compare);
+
+	fprintf(stream, "{\n  \"allocations\": %lu,\n  \"pools\": [", (unsigned long)total);
+
+	for(i = 0; i < length; i++)
+	{
+		site = sites[i];
+		for(slabs = 1; slabs < site->peak_no; slabs <<= 1);
+
+		fprintf(stream, "%s\n    { \"site\": ", (i ? "," : ""));
+		at_json_string(stream, site->filename);
+		fprintf(stream, ", \"line\": %d, \"function\": ", site->line);
+		at_json_string(stream, site->function);
+		fprintf(stream,
+		        ", \"size\": %lu, \"slabs\": %lu, \"hit_rate\": %.3f, \"allocations\": %lu,"
+		        " \"peak_live\": %lu, \"mean_lifetime_ms\": %lu }",
+		        (unsigned long)(site->size_major), (unsigned long)slabs,
+		        ((double)(site->size_hits) / (double)(site->alloc_no)),
+		        (unsigned long)(site->alloc_no), (unsigned long)(site->peak_no),
+		        (unsigned long)(site->lifetime_no ? (site->lifetime_sum / site->lifetime_no) : 0));
+	}
+
+	fprintf(stream, "%s],\n", (length ? "\n  " : ""));
+	at_recommend_classes(stream, total);
+	fprintf(stream, "}\n");
+
+	at_meta_free_null(sites);
+	AT_UNLOCK();
+
+	if(path) return ((fclose(stream) == 0) ? 0 : -1);
+	fflush(stream);
+	return 0;
+}
+
+static void at_report_leaks(void)
+{
+	at_site_t **sites = NULL;
+	size_t length = at_leak_collect(&sites), i = 0;
+	char *source = NULL, *func = NULL;
+
+	if(!length)
+	{
+		at_meta_free_null(sites);
+		return;
+	}
+
+	fprintf(stderr, "leak suspects after %lu scan%s:\n", (unsigned long)leak_pass_no,
+	        ((leak_pass_no == 1) ? "" : "s"));
+
+	for(i = 0; i < length; i++)
+	{
+		source = at_truncate(at_basename(sites[i]->filename), 20);
+		func = at_truncate(sites[i]->function, 20);
+
+		fprintf(stderr,
+			"  %20s:%-4d  %-22s  score %3u  %lu of %lu blocks old (oldest %lu ms),"
+			" grew %lu scan%s\n", source, sites[i]->line, func, sites[i]->leak_score,
+			(unsigned long)((sites[i]->leak_old_no < sites[i]->live_no) ?
+			                sites[i]->leak_old_no : sites[i]->live_no),
+			(unsigned long)(sites[i]->live_no),
+			(unsigned long)(sites[i]->leak_oldest), (unsigned long)(sites[i]->leak_streak),
+			((sites[i]->leak_streak == 1) ? "" : "s"));
+
+		at_meta_free_null(source);
+		at_meta_free_null(func);
+	}
+
+	fprintf(stderr, "\n");
+	at_meta_free_null(sites);
+}
+
+static int at_fault_site_compare(const void *a, const void *b)
+{
+	const at_site_t *x = *(const at_site_t * const *)a;
+	const at_site_t *y = *(const at_site_t * const *)b;
+	size_t m = (x->fault_minor + x->fault_major + x->fault_touched);
+	size_t n = (y->fault_minor + y->fault_major + y->fault_touched);
+
+	if(m > n) return -1;
+	return (m < n);
+}
+
+static void at_report_faults(void)
+{
+	at_site_t **sites = NULL, *site = NULL;
+	size_t length = 0, i = 0;
+	char *source = NULL, *func = NULL;
+
+	for(i = 0; i < site_table.length; i++)
+	{
+		site = site_table.sites[i];
+		length += ((site->fault_minor + site->fault_major + site->fault_touched) != 0);
+	}
+
+	if(!length || !(sites = (at_site_t **)at_meta_malloc(length * sizeof(at_site_t *)))) return;
+
+	for(i = 0, length = 0; i < site_table.length; i++)
+	{
+		site = site_table.sites[i];
+		if(site->fault_minor || site->fault_major || site->fault_touched) sites[length++] = site;
+	}
+
+	qsort(sites, length, sizeof(at_site_t *), at_fault_site_compare);
+
+	if(fault_period) fprintf(stderr, "page faults in large blocks, sampled every %u:\n", fault_period);
+	else fprintf(stderr, "pages first touched in large blocks:\n");
+
+	for(i = 0; i < length; i++)
+	{
+		source = at_truncate(at_basename(sites[i]->filename), 20);
+		func = at_truncate(sites[i]->function, 20);
+
+		if(fault_period)
+			fprintf(stderr, "  %20s:%-4d  %-22s  ~%lu minor  ~%lu major\n", source, sites[i]->line,
+			        func, (unsigned long)(sites[i]->fault_minor), (unsigned long)(sites[i]->fault_major));
+		else
+			fprintf(stderr, "  %20s:%-4d  %-22s  %lu page%s\n", source, sites[i]->line, func,
+			        (unsigned long)(sites[i]->fault_touched), ((sites[i]->fault_touched == 1) ? "" : "s"));
+
+		at_meta_free_null(source);
+		at_meta_free_null(func);
+	}
+
+	if(fault_period)
+		fprintf(stderr, "\n  ~%lu fault%s elsewhere, ~%lu lost\n",
+		        (unsigned long)fault_unattributed, ((fault_unattributed == 1) ? "" : "s"),
+		        (unsigned long)fault_lost);
+
+	fprintf(stderr, "\n");
+	at_meta_free_null(sites);
+}
+
+static void at_report_arenas(void)
+{
+	at_arena_t *arena = NULL;
+	char *name = NULL;
+
+	if(!arena_list) return;
+	fprintf(stderr, "arenas:\n");
+
+	for(arena = arena_list; arena; arena = arena->next)
+	{
+		name = at_truncate(arena->name, 20);
+
+		fprintf(stderr,
+			"  %-20s  %10lu bytes used  peak %10lu  reserved %10lu  %8lu allocations  %6lu resets%s\n",
+			name, (unsigned long)(arena->used), (unsigned long)(arena->peak),
+			(unsigned long)(arena->reserved), (unsigned long)(arena->alloc_no),
+			(unsigned long)(arena->reset_no), (arena->destroyed ? "  (destroyed)" : ""));
+
+		at_meta_free_null(name);
+	}
+
+	fprintf(stderr, "\n");
+}
+
+static void at_report_realloc(void)
+{
+	at_site_t *site = NULL;
+	size_t i = 0, flagged = 0;
+	char linear = (char)0, moving = (char)0;
+	char *source = NULL, *func = NULL;
+
+	for(i = 0; i < site_table.length; i++)
+	{
+		site = site_table.sites[i];
+		if(site->realloc_no < AT_REALLOC_MIN_CALLS) continue;
+
+		linear = (char)(site->realloc_grown && ((site->realloc_linear * 2) >= site->realloc_grown));
+		moving = (char)((site->realloc_moves * 2) >= site->realloc_no);
+		if(!linear && !moving) continue;
+
+		if(!(flagged++)) fprintf(stderr, "realloc growth:\n");
+
+		source = at_truncate(at_basename(site->filename), 20);
+		func = at_truncate(site->function, 20);
+
+		fprintf(stderr,
+			"  %20s:%-4d  %-22s  %lu reallocs (%.1f per block), growth x%.2f, "
+			"%lu%% moved, %lu B copied%s%s\n", source, site->line, func,
+			(unsigned long)(site->realloc_no),
+			((double)(site->realloc_no) / (double)(site->realloc_chains ? site->realloc_chains : 1)),
+			(site->realloc_grown ? (site->realloc_growth / (double)(site->realloc_grown)) : 1.0),
+			(unsigned long)((site->realloc_moves * 100) / site->realloc_no),
+			(unsigned long)(site->realloc_copied),
+			(linear ? "  [linear growth]" : ""),
+			(moving ? "  [frequent moves]" : ""));
+
+		at_meta_free_null(source);
+		at_meta_free_null(func);
+	}
+
+	if(flagged)
+		fprintf(stderr,
+			"\n  reserve capacity up front, or grow geometrically, at %lu site%s\n\n",
+			(unsigned long)flagged, ((flagged == 1) ? "" : "s"));
+}
+
+/* the counters keep running outside of the lock, they are read atomically */
+static void at_report_meta_time(const char *label, const at_meta_timer_t *timer)
+{
+	uint64_t time = __atomic_load_n(&(timer->time), __ATOMIC_RELAXED);
+	uint64_t call_no = __atomic_load_n(&(timer->call_no), __ATOMIC_RELAXED);
+
+	if(!call_no) return;
+	fprintf(stderr, "  %-22s %lu us in %lu calls (%lu ns per call)\n", label,
+	        (unsigned long)(time / 1000), (unsigned long)call_no,
+	        (unsigned long)(time / call_no));
+}
+
+static void at_report_print(void)
+{
+	at_heap_list_item_t *heap_item = NULL;
+	at_file_list_item_t *file_item = NULL;
+	at_map_list_item_t *map_item = NULL;
+	at_site_t *site = NULL;
+	size_t leaksum = 0, leaks = 0, open = 0, mapsum = 0, maps = 0, fd = 0;
+	size_t remote_free_no = 0, i = 0;
+	char *file = NULL, *source = NULL, *func = NULL;
+	char detail[48];
+
+	if(!can_report) return;
+	if(!at_list_length(heap_list) && !(compact.live) && !at_list_length(file_list) &&
+	   !at_list_length(map_list) && !(fd_table.length)) return;
+
+	fprintf(stderr, "\nALLOC TRACKER REPORT:\n\n");
+
+	if(at_list_length(heap_list) || compact.live)
+	{
+		heap_item = (heap_list ? (at_heap_list_item_t *)(heap_list->first) : NULL);
+		fprintf(stderr, "unfreed memory:\n");
+
+		while(heap_item)
+		{
+			leaksum += heap_item->size;
+			++leaks;
+
+			source = at_truncate(at_basename(heap_item->filename), 20);
+			func = at_truncate(heap_item->function, 20);
+
+			if(heap_item->alignment)
+				snprintf(detail, sizeof(detail), "  [%s%saligned %lu]",
+				         ((heap_item->kind != AT_ALLOC_KIND_MALLOC) ?
+				          at_alloc_kind_name(heap_item->kind, (char)0) : ""),
+				         ((heap_item->kind != AT_ALLOC_KIND_MALLOC) ? ", " : ""),
+				         (unsigned long)(heap_item->alignment));
+			else if(heap_item->kind != AT_ALLOC_KIND_MALLOC)
+				snprintf(detail, sizeof(detail), "  [%s]",
+				         at_alloc_kind_name(heap_item->kind, (char)0));
+			else detail[0] = '\0';
+
+			fprintf(stderr,
+				"  %-18p  %6ld B  %20s:%-4d  %s%s%s\n", heap_item->pointer,
+				heap_item->size, source, heap_item->line, func,
+				(strlen(func) ? "()" : ""), detail);
+
+			heap_item = heap_item->next;
+			at_meta_free_null(source);
+			at_meta_free_null(func);
+		}
+
+		/* blocks tracked in compact mode follow, in allocation order too */
+		if(compact.live)
+			fprintf(stderr, "  %lu compact record%s, after the fully tracked blocks:\n",
+			        (unsigned long)(compact.live), ((compact.live == 1) ? "" : "s"));
+
+		for(i = 0; i < compact.length; i++)
+		{
+			if(!(compact.records[i].word & AT_COMPACT_ADDRESS)) continue;
+			site = at_compact_site(&(compact.records[i]));
+			leaksum += at_compact_size(&(compact.records[i]));
+			++leaks;
+
+			source = at_truncate(at_basename(site->filename), 20);
+			func = at_truncate(site->function, 20);
+
+			fprintf(stderr,
+				"  %-18p  %6ld B  %20s:%-4d  %s%s\n", at_compact_pointer(&(compact.records[i])),
+				(long)at_compact_size(&(compact.records[i])), source, site->line, func,
+				(strlen(func) ? "()" : ""));
+
+			at_meta_free_null(source);
+			at_meta_free_null(func);
+		}
+
+		fprintf(stderr,
+			"\n  overall %lu byte%s in %lu block%s unfreed\n\n",
+			leaksum, ((leaksum == 1) ? "" : "s"), leaks,
+			((leaks == 1) ? "" : "s"));
+	}
+
+	if(file_list && (file_list->length))
+	{
+		file_item = (at_file_list_item_t *)(file_list->first);
+
+		if(file_item) fprintf(stderr, "unclosed files:\n");
+
+		while(file_item)
+		{
+			++open;
+			file = at_truncate(at_basename(file_item->name), 20);
+			source = at_truncate(at_basename(file_item->filename), 20);
+			func = at_truncate(file_item->function, 20);
+
+			fprintf(stderr,
+				"  %-18p  %-20s  %-3s  %20s:%-4d  %s%s\n", (void *)(file_item->handle),
+				file, file_item->mode, source, file_item->line, func,
+				(strlen(func) ? "()" : ""));
+
+			file_item = file_item->next;
+			at_meta_free_null(file);
+			at_meta_free_null(source);
+			at_meta_free_null(func);
+		}
+
+		fprintf(stderr,
+			"\n  overall %lu file%s unclosed\n\n",
+			open, ((open == 1) ? "" : "s"));
+
+		file_item = (at_file_list_item_t *)(file_list->first);
+		open = 0;
+
+		while(file_item)
+		{
+			if(file_item->read_no || file_item->write_no)
+			{
+				if(!(open++)) fprintf(stderr, "stream I/O:\n");
+
+				file = at_truncate(at_basename(file_item->name), 20);
+				at_file_buffer_describe(file_item, detail, sizeof(detail));
+
+				fprintf(stderr,
+					"  %-18p  %-20s  read %lu B in %lu (%lu B each), "
+					"written %lu B in %lu (%lu B each)  %s%s%s\n",
+					(void *)(file_item->handle), file,
+					(unsigned long)(file_item->read_amount),
+					(unsigned long)(file_item->read_no),
+					(unsigned long)(file_item->read_no ?
+						(file_item->read_amount / file_item->read_no) : 0),
+					(unsigned long)(file_item->write_amount),
+					(unsigned long)(file_item->write_no),
+					(unsigned long)(file_item->write_no ?
+						(file_item->write_amount / file_item->write_no) : 0), detail,
+					(at_file_io_tiny(file_item, (char)0) ? "  [tiny reads]" : ""),
+					(at_file_io_tiny(file_item, (char)1) ? "  [tiny writes]" : ""));
+
+				at_meta_free_null(file);
+			}
+
+			file_item = file_item->next;
+		}
+
+		if(open) fprintf(stderr, "\n");
+	}
+
+	if(map_list && (map_list->length))
+	{
+		map_item = (at_map_list_item_t *)(map_list->first);
+
+		if(map_item) fprintf(stderr, "unreleased mappings:\n");
+
+		while(map_item)
+		{
+			mapsum += map_item->size;
+			++maps;
+
+			source = at_truncate(at_basename(map_item->filename), 20);
+			func = at_truncate(map_item->function, 20);
+			snprintf(detail, sizeof(detail), "%s %s",
+			         ((map_item->fd < 0) ? "anon" : "file"),
+			         ((map_item->flags & MAP_SHARED) ? "shared" : "private"));
+
+			if(map_item->pagesize)
+				snprintf(&detail[strlen(detail)], (sizeof(detail) - strlen(detail)),
+				         " huge %luk", (unsigned long)(map_item->pagesize >> 10));
+
+			fprintf(stderr,
+				"  %-18p  %10lu B  %-20s  %20s:%-4d  %s%s\n", map_item->pointer,
+				(unsigned long)(map_item->size), detail, source, map_item->line,
+				func, (strlen(func) ? "()" : ""));
+
+			map_item = map_item->next;
+			at_meta_free_null(source);
+			at_meta_free_null(func);
+		}
+
+		fprintf(stderr,
+			"\n  overall %lu byte%s in %lu mapping%s unreleased\n\n",
+			mapsum, ((mapsum == 1) ? "" : "s"), maps,
+			((maps == 1) ? "" : "s"));
+	}
+
+	at_report_realloc();
+	at_report_threads();
+	at_report_sharing();
+	at_report_scopes();
+	at_report_duplicates();
+	at_report_unused();
+	at_report_leaks();
+	at_report_faults();
+	at_report_arenas();
+
+	if(fd_table.length)
+	{
+		fprintf(stderr, "unclosed descriptors:\n");
+		open = 0;
+
+		for(fd = 0; fd < fd_table.capacity; fd++)
+		{
+			if(!(fd_table.items[fd].open)) continue;
+
+			++open;
+			source = at_truncate(at_basename(fd_table.items[fd].filename), 20);
+			func = at_truncate(fd_table.items[fd].function, 20);
+
+			fprintf(stderr,
+				"  fd %-14lu  %-8s  %20s:%-4d  %s%s\n", (unsigned long)fd,
+				at_fd_type_name(fd_table.items[fd].type), source,
+				fd_table.items[fd].line, func, (strlen(func) ? "()" : ""));
+
+			at_meta_free_null(source);
+			at_meta_free_null(func);
+		}
+
+		fprintf(stderr,
+			"\n  overall %lu descriptor%s unclosed\n\n",
+			open, ((open == 1) ? "" : "s"));
+	}
+
+	if(!can_record) return;
+
+	for(i = 0; i < site_table.length; i++)
+		remote_free_no += site_table.sites[i]->remote_free_no;
+
+	fprintf(stderr, "system resource summary:\n");
+	fprintf(stderr, "  heap space allocated:  %lu bytes\n", stats.alloc_amount);
+	fprintf(stderr, "  heap space freed:      %lu bytes\n", stats.free_amount);
+	fprintf(stderr, "  peak heap in use:      %lu bytes\n", (unsigned long)heap_peak_amount);
+	fprintf(stderr, "  allocations:           %lu\n", stats.alloc_no);
+	fprintf(stderr, "  frees:                 %lu\n", stats.free_no);
+	fprintf(stderr, "  files opened:          %lu\n", stats.open_no);
+	fprintf(stderr, "  files closed:          %lu\n", stats.close_no);
+
+	if(remote_free_no)
+		fprintf(stderr, "  cross-thread frees:    %lu\n", (unsigned long)remote_free_no);
+
+	if(stats.mismatch_no)
+		fprintf(stderr, "  mismatched releases:   %lu\n", (unsigned long)(stats.mismatch_no));
+
+	if(stats.untracked_no)
+		fprintf(stderr, "  untracked releases:    %lu\n", (unsigned long)(stats.untracked_no));
+
+	if(fd_stats.open_no)
+	{
+		fprintf(stderr, "  descriptors opened:    %lu\n", fd_stats.open_no);
+		fprintf(stderr, "  descriptors closed:    %lu\n", fd_stats.close_no);
+		fprintf(stderr, "  peak open descriptors: %lu\n", fd_stats.peak_no);
+	}
+
+	if(map_stats.map_no)
+	{
+		fprintf(stderr, "  memory mapped:         %lu bytes\n", map_stats.map_amount);
+		fprintf(stderr, "  memory unmapped:       %lu bytes\n", map_stats.unmap_amount);
+		fprintf(stderr, "  peak memory mapped:    %lu bytes\n", map_stats.peak_amount);
+		fprintf(stderr, "  huge page mappings:    %lu bytes\n", map_stats.huge_amount);
+		fprintf(stderr, "  mappings:              %lu\n", map_stats.map_no);
+		fprintf(stderr, "  unmappings:            %lu\n", map_stats.unmap_no);
+	}
+
+	/* the tracker's own cost, including what this report allocated so far */
+	fprintf(stderr, "  tracker allocations:   %lu\n",
+	        (unsigned long)__atomic_load_n(&(meta_stats.alloc_no), __ATOMIC_RELAXED));
+	fprintf(stderr, "  tracker metadata:      %lu bytes (peak %lu bytes)\n",
+	        (unsigned long)__atomic_load_n(&(meta_stats.held_amount), __ATOMIC_RELAXED),
+	        (unsigned long)__atomic_load_n(&(meta_stats.peak_amount), __ATOMIC_RELAXED));
+
+	if(compact.capacity)
+		fprintf(stderr, "  compact records:       %lu live of %lu, %lu squeeze%s\n",
+		        (unsigned long)(compact.live), (unsigned long)(compact.capacity),
+		        (unsigned long)(compact.squeeze_no), ((compact.squeeze_no == 1) ? "" : "s"));
+
+	at_report_meta_time("time allocating:", &(meta_stats.alloc));
+	at_report_meta_time("time releasing:", &(meta_stats.free));
+	at_report_meta_time("time in at_list_get:", &(meta_stats.lookup));
+	at_report_meta_time("time in at_report:", &(meta_stats.report));
+	fprintf(stderr, "\n\n");
+}
+
+void at_report(void)
+{
+	uint64_t start = at_meta_clock();
+
+	AT_LOCK();
+	at_report_print();
+	AT_UNLOCK();
+	at_meta_time(&(meta_stats.report), start);
+}
+
+static void at_dump_signal(int signo)
+{
+	(void)signo;
+	sem_post(&dump_request);
+}
+
+/* the report cannot be written from the signal handler, which merely
+   wakes up a thread writing it */
+static void *at_dump_run(void *unused)
+{
+	(void)unused;
+
+	for(;;)
+	{
+		if(sem_wait(&dump_request) != 0) continue;
+		if(dump_stopping) break;
+		at_report();
+	}
+
+	return NULL;
+}
+
+int at_dump_on_signal(int signo)
+{
+	struct sigaction action;
+	int result = 0;
+
+	if((signo <= 0) || (signo >= NSIG)) return -1;
+	pthread_mutex_lock(&leak_control);
+
+	if(!dump_armed)
+	{
+		dump_stopping = (char)0;
+
+		if((sem_init(&dump_request, 0, 0) != 0) ||
+		   (pthread_create(&dump_thread, NULL, at_dump_run, NULL) != 0))
+		{
+			fprintf(stderr, "[dump] failed to start dump thread\n");
+			pthread_mutex_unlock(&leak_control);
+			return -1;
+		}
+
+		dump_armed = (char)1;
+	}
+
+	memset(&action, '\0', sizeof(struct sigaction));
+	action.sa_handler = at_dump_signal;
+	action.sa_flags = SA_RESTART;
+	sigemptyset(&(action.sa_mask));
+
+	/* the handler replaced first is the one restored by "at_dump_stop" */
+	if(sigismember(&dump_signals, signo) == 1) result = sigaction(signo, &action, NULL);
+	else if(!(result = sigaction(signo, &action, &(dump_previous[signo]))))
+		sigaddset(&dump_signals, signo);
+
+	pthread_mutex_unlock(&leak_control);
+	return result;
+}
+
+/* restores the handlers replaced by "at_dump_on_signal" before the dump
+   thread is stopped, so that no request is posted to it afterwards */
+void at_dump_stop(void)
+{
+	int signo = 0;
+
+	pthread_mutex_lock(&leak_control);
+
+	if(!dump_armed)
+	{
+		pthread_mutex_unlock(&leak_control);
+		return;
+	}
+
+	for(signo = 1; signo < NSIG; signo++)
+		if(sigismember(&dump_signals, signo) == 1)
+			sigaction(signo, &(dump_previous[signo]), NULL);
+
+	sigemptyset(&dump_signals);
+	dump_stopping = (char)1;
+	sem_post(&dump_request);
+	pthread_join(dump_thread, NULL);
+	sem_destroy(&dump_request);
+	dump_armed = (char)0;
+
+	pthread_mutex_unlock(&leak_control);
+}
+
+/* as "at_report" followed by "at_free_all", but unless "release" is set
+   the blocks, streams, and mappings still tracked are left to the exit */
+void at_shutdown(int release)
+{
+	uint64_t start = 0;
+
+	at_dump_stop();
+	start = at_meta_clock();
+	AT_LOCK();
+	at_report_print();
+	at_meta_time(&(meta_stats.report), start);
+	at_teardown((char)(release != 0));
+	AT_UNLOCK();
+}
+
+#ifndef AT_REACH_SIGNAL
+#define AT_REACH_SIGNAL SIGPWR
+#endif
+
+/* the words read by the mark phase include poisoned stack and global
+   redzones when built with sanitizers */
+#define AT_NO_SANITIZE __attribute__((no_sanitize_address, no_sanitize_thread))
+
+static void *at_reach_map(size_t size)
+{
+	void *mapping = mmap(NULL, size, (PROT_READ | PROT_WRITE),
+	                     (MAP_PRIVATE | MAP_ANONYMOUS), -1, 0);
+	return ((mapping == MAP_FAILED) ? NULL : mapping);
+}
+
+static int at_reach_tid(void)
+{
+	return (int)syscall(SYS_gettid);
+}
+
+static int at_reach_block_compare(const void *a, const void *b)
+{
+	const at_reach_block_t *x = (const at_reach_block_t *)a;
+	const at_reach_block_t *y = (const at_reach_block_t *)b;
+
+	if(x->start < y->start) return -1;
+	return (x->start > y->start);
+}
+
+static void at_reach_root(uintptr_t start, uintptr_t end)
+{
+	if(start >= end) return;
+
+	if(reach_state->root_no >= reach_state->root_capacity)
+	{
+		++(reach_state->root_dropped);
+		return;
+	}
+
+	reach_state->roots[reach_state->root_no].start = start;
+	reach_state->roots[reach_state->root_no].end = end;
+	++(reach_state->root_no);
+}
+
+/* adds the writable segments as roots, or merely counts them into "count" */
+static int at_reach_segment(struct dl_phdr_info *info, size_t size, void *count)
+{
+	const ElfW(Phdr) *header = NULL;
+	size_t i = 0;
+
+	(void)size;
+
+	for(i = 0; i < info->dlpi_phnum; i++)
+	{
+		header = &(info->dlpi_phdr[i]);
+		if((header->p_type != PT_LOAD) || !(header->p_flags & PF_W)) continue;
+
+		if(count) ++(*(size_t *)count);
+		else at_reach_root((uintptr_t)(info->dlpi_addr + header->p_vaddr),
+		                   (uintptr_t)(info->dlpi_addr + header->p_vaddr + header->p_memsz));
+	}
+
+	return 0;
+}
+
+/* the mappings of the process, to find the top of every stack */
+static void at_reach_read_maps(void)
+{
+	size_t size = (1 << 20), length = 0, capacity = 0;
+	char *buffer = NULL, *line = NULL, *end = NULL;
+	ssize_t count = 0;
+	int fd = -1;
+
+	if((fd = open("/proc/self/maps", O_RDONLY)) < 0) return;
+	if(!(buffer = (char *)at_reach_map(size)))
+	{
+		close(fd);
+		return;
+	}
+
+	while((length < (size - 1)) &&
+	      ((count = read(fd, (buffer + length), (size - 1 - length))) > 0))
+		length += (size_t)count;
+
+	close(fd);
+	buffer[length] = '\0';
+
+	for(line = buffer; *line; line = (end ? (end + 1) : (line + strlen(line))))
+	{
+		end = strchr(line, '\n');
+		++capacity;
+	}
+
+	if(!capacity || !(reach_state->maps =
+	   (at_reach_range_t *)at_reach_map(capacity * sizeof(at_reach_range_t))))
+	{
+		munmap(buffer, size);
+		return;
+	}
+
+	reach_state->map_capacity = capacity;
+
+	for(line = buffer; *line && (reach_state->map_no < capacity);
+	    line = (end ? (end + 1) : (line + strlen(line))))
+	{
+		reach_state->maps[reach_state->map_no].start = (uintptr_t)strtoul(line, &end, 16);
+		if(*end == '-')
+			reach_state->maps[(reach_state->map_no)++].end = (uintptr_t)strtoul((end + 1), NULL, 16);
+		end = strchr(line, '\n');
+	}
+
+	munmap(buffer, size);
+}
+
+/* the stack holding "sp" ends where the first mapping above it ends;
+   the main stack may have grown below its mapping as read */
+static uintptr_t at_reach_stack_top(uintptr_t sp)
+{
+	size_t i = 0;
+
+	for(i = 0; i < reach_state->map_no; i++)
+		if(reach_state->maps[i].end > sp) return reach_state->maps[i].end;
+
+	return sp;
+}
+
+static void at_reach_tasks(void)
+{
+	char buffer[4096];
+	struct linux_dirent64
+	{
+		uint64_t d_ino;
+		int64_t d_off;
+		unsigned short d_reclen;
+		unsigned char d_type;
+		char d_name[];
+	} *entry = NULL;
+	long count = 0, offset = 0;
+	int fd = -1, self = at_reach_tid(), tid = 0;
+	size_t i = 0;
+
+	if((fd = open("/proc/self/task", (O_RDONLY | O_DIRECTORY))) < 0) return;
+
+	while((count = syscall(SYS_getdents64, fd, buffer, sizeof(buffer))) > 0)
+	{
+		for(offset = 0; offset < count; offset += entry->d_reclen)
+		{
+			entry = (struct linux_dirent64 *)(buffer + offset);
+			if(!(tid = atoi(entry->d_name)) || (tid == self)) continue;
+
+			for(i = 0; (i < reach_state->workers) && (reach_state->worker_tids[i] != tid); i++);
+			if(i < reach_state->workers) continue;
+
+			if(reach_state->task_no < AT_REACH_TASKS)
+				reach_state->tasks[(reach_state->task_no)++] = tid;
+			else ++(reach_state->task_dropped);
+		}
+	}
+
+	close(fd);
+}
+
+/* "reach_window" holds the generation of the scan in its upper half, and
+   whether threads may still park along with how many did in its lower
+   half; it and the stacks live outside the state of a scan, which is gone
+   when a signal delayed beyond the timeout arrives */
+#define AT_REACH_OPEN ((uint64_t)1 << 31)
+#define AT_REACH_PARKED (AT_REACH_OPEN - 1)
+
+/* a suspended thread records where its stack, with the registers saved
+   by the kernel on top, begins, and waits to be resumed; once its scan
+   closed the window the signal is ignored */
+static void at_reach_park(int signo)
+{
+	volatile char here = '\0';
+	uint64_t window = __atomic_load_n(&reach_window, __ATOMIC_ACQUIRE);
+	unsigned int generation = 0, resumed = 0;
+	size_t slot = 0;
+	int saved = errno;
+	char byte = '\0';
+
+	(void)signo;
+
+	do
+	{
+		if(!(window & AT_REACH_OPEN)) return;
+	}
+	while(!__atomic_compare_exchange_n(&reach_window, &window, (window + 1), 0,
+	                                   __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+
+	generation = (unsigned int)(window >> 32);
+	slot = (size_t)(window & AT_REACH_PARKED);
+	if(slot < AT_REACH_TASKS) __atomic_store_n(&(reach_stacks[slot]), (uintptr_t)&here, __ATOMIC_RELEASE);
+
+	/* the acknowledgement carries the generation, so that one written too
+	   late is not counted for the next scan */
+	byte = (char)generation;
+	while((write(reach_ack[1], &byte, 1) < 0) && (errno == EINTR));
+
+	while((int)((resumed = __atomic_load_n(&reach_resumed, __ATOMIC_ACQUIRE)) - generation) < 0)
+		syscall(SYS_futex, &reach_resumed, FUTEX_WAIT_PRIVATE, resumed, NULL, NULL, 0);
+
+	errno = saved;
+}
+
+/* returns the number of threads stopped */
+static size_t at_reach_suspend(unsigned int generation, size_t *signaled)
+{
+	struct sigaction action;
+	struct pollfd ready;
+	size_t acked = 0, i = 0;
+	char byte = '\0';
+
+	memset(&action, '\0', sizeof(struct sigaction));
+	action.sa_handler = at_reach_park;
+	action.sa_flags = SA_RESTART;
+	sigfillset(&(action.sa_mask));
+	sigaction(AT_REACH_SIGNAL, &action, &reach_previous);
+
+	/* acknowledgements left over from threads which stopped too late */
+	ready.fd = reach_ack[0];
+	ready.events = POLLIN;
+	while((poll(&ready, 1, 0) == 1) && (read(reach_ack[0], &byte, 1) == 1));
+
+	memset(reach_stacks, '\0', sizeof(reach_stacks));
+	__atomic_store_n(&reach_window, (((uint64_t)generation << 32) | AT_REACH_OPEN), __ATOMIC_RELEASE);
+
+	for(i = 0; i < reach_state->task_no; i++)
+		if(!syscall(SYS_tgkill, getpid(), reach_state->tasks[i], AT_REACH_SIGNAL)) ++(*signaled);
+
+	while((acked < *signaled) && (poll(&ready, 1, 1000) == 1))
+		if((read(reach_ack[0], &byte, 1) == 1) && ((unsigned char)byte == (unsigned char)generation))
+			++acked;
+
+	return acked;
+}
+
+/* closes the window, so that a thread stopping only now returns at once,
+   resumes every thread which parked, and restores the previous handler */
+static void at_reach_resume(unsigned int generation)
+{
+	__atomic_store_n(&reach_window, ((uint64_t)generation << 32), __ATOMIC_RELEASE);
+	__atomic_store_n(&reach_resumed, generation, __ATOMIC_RELEASE);
+	syscall(SYS_futex, &reach_resumed, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+	sigaction(AT_REACH_SIGNAL, &reach_previous, NULL);
+}
+
+static size_t at_reach_find(uintptr_t word)
+{
+	size_t low = 0, high = reach_state->length;
+
+	while(low < high)
+	{
+		if(reach_state->blocks[((low + high) / 2)].start <= word) low = ((low + high) / 2) + 1;
+		else high = ((low + high) / 2);
+	}
+
+	if(!low || (word >= reach_state->blocks[(low - 1)].end)) return (size_t)(-1);
+	return (low - 1);
+}
+
+static void at_reach_spill(at_reach_range_t *local, size_t *length)
+{
+	size_t half = (*length / 2);
+
+	pthread_mutex_lock(&reach_lock);
+	memcpy(&(reach_state->queue[reach_state->queue_length]), local,
+	       (half * sizeof(at_reach_range_t)));
+	reach_state->queue_length += half;
+	memmove(local, (local + half), ((*length - half) * sizeof(at_reach_range_t)));
+	*length -= half;
+	pthread_cond_broadcast(&reach_wake);
+	pthread_mutex_unlock(&reach_lock);
+}
+
+/* large blocks are scanned in pieces, which idle workers can take over */
+static void at_reach_push(at_reach_range_t *local, size_t *length, uintptr_t start, uintptr_t end)
+{
+	for(; start < end; start += AT_REACH_CHUNK)
+	{
+		if((*length == AT_REACH_LOCAL) ||
+		   ((*length > 1) && __atomic_load_n(&(reach_state->idle), __ATOMIC_RELAXED)))
+			at_reach_spill(local, length);
+
+		local[*length].start = start;
+		local[(*length)++].end = (((end - start) > AT_REACH_CHUNK) ? (start + AT_REACH_CHUNK) : end);
+	}
+}
+
+AT_NO_SANITIZE static void at_reach_scan_range(at_reach_range_t range,
+	at_reach_range_t *local, size_t *length)
+{
+	uintptr_t address = ((range.start + sizeof(uintptr_t) - 1) & ~(uintptr_t)(sizeof(uintptr_t) - 1));
+	uintptr_t word = 0;
+	size_t i = 0;
+
+	for(; (address + sizeof(uintptr_t)) <= range.end; address += sizeof(uintptr_t))
+	{
+		word = *(const volatile uintptr_t *)address;
+		if((word < reach_state->low) || (word >= reach_state->high)) continue;
+		if((i = at_reach_find(word)) == (size_t)(-1)) continue;
+		if(__atomic_exchange_n(&(reach_state->marks[i]), 1, __ATOMIC_RELAXED)) continue;
+		at_reach_push(local, length, reach_state->blocks[i].start, reach_state->blocks[i].end);
+	}
+}
+
+static void at_reach_work(void)
+{
+	at_reach_range_t local[AT_REACH_LOCAL];
+	size_t length = 0;
+
+	for(;;)
+	{
+		while(length)
+		{
+			--length;
+			at_reach_scan_range(local[length], local, &length);
+		}
+
+		pthread_mutex_lock(&reach_lock);
+
+		while(!(reach_state->queue_length) && !(reach_state->done))
+		{
+			if((reach_state->idle + 1) == reach_state->workers)
+			{
+				reach_state->done = (char)1;
+				pthread_cond_broadcast(&reach_wake);
+				break;
+			}
+
+			__atomic_add_fetch(&(reach_state->idle), 1, __ATOMIC_RELAXED);
+			pthread_cond_wait(&reach_wake, &reach_lock);
+			__atomic_sub_fetch(&(reach_state->idle), 1, __ATOMIC_RELAXED);
+		}
+
+		while(reach_state->queue_length && (length < AT_REACH_BATCH))
+			local[length++] = reach_state->queue[--(reach_state->queue_length)];
+
+		pthread_mutex_unlock(&reach_lock);
+		if(!length) return;
+	}
+}
+
+static void *at_reach_worker(void *index)
+{
+	reach_state->worker_tids[(size_t)index] = at_reach_tid();
+	sem_post(&reach_ready);
+	while(sem_wait(&reach_start) != 0);
+	at_reach_work();
+	return NULL;
+}
+
+static int at_reach_site_compare(const void *a, const void *b)
+{
+	const at_site_t *x = *(const at_site_t * const *)a;
+	const at_site_t *y = *(const at_site_t * const *)b;
+
+	if(x->reach_amount > y->reach_amount) return -1;
+	return (x->reach_amount < y->reach_amount);
+}
+
+static void at_reach_report(size_t stopped, size_t signaled)
+{
+	at_site_t **sites = NULL;
+	size_t i = 0, length = 0, blocks = 0, bytes = 0;
+	char *source = NULL, *func = NULL;
+	at_site_t *site = NULL;
+
+	for(i = 0; i < site_table.length; i++)
+		site_table.sites[i]->reach_no = site_table.sites[i]->reach_amount = 0;
+
+	for(i = 0; i < reach_state->length; i++)
+	{
+		if(reach_state->marks[i]) continue;
+		++blocks;
+		bytes += (reach_state->blocks[i].end - reach_state->blocks[i].start);
+		if(!(site = reach_state->blocks[i].site)) continue;
+		if(!(site->reach_no++)) ++length;
+		site->reach_amount += (reach_state->blocks[i].end - reach_state->blocks[i].start);
+	}
+
+	if(stopped < signaled)
+		fprintf(stderr, "[reach] %lu thread%s did not stop, %s not scanned\n",
+		        (unsigned long)(signaled - stopped), (((signaled - stopped) == 1) ? "" : "s"),
+		        (((signaled - stopped) == 1) ? "its stack was" : "their stacks were"));
+
+	if(reach_state->task_dropped)
+		fprintf(stderr, "[reach] %lu thread%s beyond AT_REACH_TASKS neither stopped nor scanned\n",
+		        (unsigned long)(reach_state->task_dropped), ((reach_state->task_dropped == 1) ? "" : "s"));
+
+	if(reach_state->root_dropped)
+		fprintf(stderr, "[reach] %lu root%s dropped, blocks referenced only from %s are reported\n",
+		        (unsigned long)(reach_state->root_dropped), ((reach_state->root_dropped == 1) ? "" : "s"),
+		        ((reach_state->root_dropped == 1) ? "it" : "them"));
+
+	fprintf(stderr, "\nunreachable memory:\n");
+
+	if(length && (sites = (at_site_t **)at_meta_malloc(length * sizeof(at_site_t *))))
+	{
+		for(i = 0, length = 0; i < site_table.length; i++)
+			if(site_table.sites[i]->reach_no) sites[length++] = site_table.sites[i];
+
+		qsort(sites, length, sizeof(at_site_t *), at_reach_site_compare);
+
+		for(i = 0; i < length; i++)
+		{
+			source = at_truncate(at_basename(sites[i]->filename), 20);
+			func = at_truncate(sites[i]->function, 20);
+
+			fprintf(stderr, "  %20s:%-4d  %-22s  %10lu bytes in %lu block%s\n",
+			        source, sites[i]->line, func, (unsigned long)(sites[i]->reach_amount),
+			        (unsigned long)(sites[i]->reach_no), ((sites[i]->reach_no == 1) ? "" : "s"));
+
+			at_meta_free_null(source);
+			at_meta_free_null(func);
+		}
+
+		at_meta_free_null(sites);
+	}
+
+	fprintf(stderr,
+		"\n  overall %lu byte%s in %lu of %lu block%s unreachable, %lu thread%s stopped\n\n",
+		(unsigned long)bytes, ((bytes == 1) ? "" : "s"), (unsigned long)blocks,
+		(unsigned long)(reach_state->length), ((reach_state->length == 1) ? "" : "s"),
+		(unsigned long)stopped, ((stopped == 1) ? "" : "s"));
+}
+
+
+/* marks every tracked block reachable from the roots, i.e. the stacks and
+   registers of all threads, the writable segments of all loaded objects
+   and tracked anonymous mappings, and reports the blocks left unmarked */
+int at_reach_scan(void)
+{
+	pthread_t workers[AT_REACH_THREADS];
+	at_heap_list_item_t *item = NULL;
+	at_map_list_item_t *map_item = NULL;
+	at_reach_t *state = NULL;
+	at_reach_range_t *root = NULL;
+	jmp_buf registers;
+	uintptr_t sp = (uintptr_t)__builtin_frame_address(0), start = 0, stack = 0;
+	size_t i = 0, created = 0, signaled = 0, stopped = 0, capacity = 0, unreachable = 0;
+	size_t blocks = 0, segments = 0, reserved = 0, parked = 0, tail = 0;
+	unsigned int generation = 0;
+	long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+	/* the callee-saved registers of this thread; the rest of the buffer
+	   must not hold what dead frames left on the stack */
+	memset(&registers, '\0', sizeof(jmp_buf));
+	setjmp(registers);
+
+	AT_LOCK();
+
+	if(!(blocks = (at_list_length(heap_list) + compact.live)))
+	{
+		AT_UNLOCK();
+		return 0;
+	}
+
+	if((reach_ack[0] < 0) &&
+	   ((pipe2(reach_ack, O_CLOEXEC) != 0) || (sem_init(&reach_ready, 0, 0) != 0) || (sem_init(&reach_start, 0, 0) != 0)))
+	{
+		fprintf(stderr, "[reach] failed to set up thread suspension\n");
+		AT_UNLOCK();
+		return -1;
+	}
+
+	if(!(state = (at_reach_t *)at_reach_map(sizeof(at_reach_t))) ||
+	   !(state->blocks = (at_reach_block_t *)at_reach_map(blocks * sizeof(at_reach_block_t))) ||
+	   !(state->marks = (unsigned char *)at_reach_map(blocks)))
+	{
+		fprintf(stderr, "[reach] failed to map the block index\n");
+		if(state && state->blocks) munmap(state->blocks, (blocks * sizeof(at_reach_block_t)));
+		if(state) munmap(state, sizeof(at_reach_t));
+		AT_UNLOCK();
+		return -1;
+	}
+
+	/* interior pointers are found by a binary search over the blocks
+	   ordered by address */
+	for(item = (heap_list ? (at_heap_list_item_t *)(heap_list->first) : NULL); item; item = item->next)
+	{
+		if(!(item->pointer) || (item->size <= 0)) continue;
+		state->blocks[state->length].start = (uintptr_t)(item->pointer);
+		state->blocks[state->length].end = ((uintptr_t)(item->pointer) + (size_t)(item->size));
+		state->blocks[(state->length)++].site = item->site;
+	}
+
+	for(i = 0; i < compact.length; i++)
+	{
+		if(!(compact.records[i].word & AT_COMPACT_ADDRESS)) continue;
+		state->blocks[state->length].start = (uintptr_t)at_compact_pointer(&(compact.records[i]));
+		state->blocks[state->length].end = (state->blocks[state->length].start +
+		                                    at_compact_size(&(compact.records[i])));
+		state->blocks[(state->length)++].site = at_compact_site(&(compact.records[i]));
+	}
+
+	qsort(state->blocks, state->length, sizeof(at_reach_block_t), at_reach_block_compare);
+	state->low = (state->length ? state->blocks[0].start : 0);
+	state->high = (state->length ? state->blocks[(state->length - 1)].end : 0);
+	reach_state = state;
+
+	/* the workers are started before any thread is stopped, which might
+	   hold a lock needed to create them */
+	state->workers = (size_t)((cpus < 1) ? 1 : ((cpus > AT_REACH_THREADS) ? AT_REACH_THREADS : cpus));
+
+	for(created = 0; (created + 1) < state->workers; created++)
+		if(pthread_create(&(workers[created]), NULL, at_reach_worker, (void *)(uintptr_t)created) != 0)
+			break;
+
+	state->workers = (created + 1);
+	for(i = 0; i < created; i++) while(sem_wait(&reach_ready) != 0);
+
+	/* threads started from here on are neither stopped nor scanned */
+	at_reach_tasks();
+	at_reach_read_maps();
+
+	/* the stacks and registers are given the first slots of the roots,
+	   followed by the writable segments and the anonymous mappings */
+	dl_iterate_phdr(at_reach_segment, &segments);
+	reserved = (state->task_no + 2);
+	capacity = (reserved + segments + at_list_length(map_list));
+
+	if((state->roots = (at_reach_range_t *)at_reach_map(capacity * sizeof(at_reach_range_t))))
+	{
+		state->root_capacity = capacity;
+		state->root_no = reserved;
+	}
+
+	dl_iterate_phdr(at_reach_segment, NULL);
+
+	for(map_item = (map_list ? (at_map_list_item_t *)(map_list->first) : NULL);
+	    map_item; map_item = map_item->next)
+		if((map_item->prot & PROT_READ) && (map_item->flags & MAP_ANONYMOUS))
+			at_reach_root((uintptr_t)(map_item->pointer),
+			              ((uintptr_t)(map_item->pointer) + map_item->size));
+
+	generation = ((unsigned int)(__atomic_load_n(&reach_window, __ATOMIC_ACQUIRE) >> 32) + 1);
+	stopped = at_reach_suspend(generation, &signaled);
+
+	/* from here on until the threads are resumed nothing may be allocated,
+	   as a stopped thread might hold a lock of the allocator; threads which
+	   were not signaled but parked all the same have no slot */
+	parked = (size_t)(__atomic_load_n(&reach_window, __ATOMIC_ACQUIRE) & AT_REACH_PARKED);
+	tail = state->root_no;
+	state->root_no = 0;
+
+	for(i = 0; (i < parked) && (i < state->task_no); i++)
+		if((stack = __atomic_load_n(&(reach_stacks[i]), __ATOMIC_ACQUIRE)))
+			at_reach_root(stack, at_reach_stack_top(stack));
+
+	if(parked > state->task_no) state->root_dropped += (parked - state->task_no);
+	at_reach_root(sp, at_reach_stack_top(sp));
+	at_reach_root((uintptr_t)&registers, ((uintptr_t)&registers + sizeof(jmp_buf)));
+	state->root_no = tail;
+
+	for(i = 0; i < state->root_no; i++)
+		capacity += (((state->roots[i].end - state->roots[i].start) + AT_REACH_CHUNK - 1) / AT_REACH_CHUNK);
+	for(i = 0; i < state->length; i++)
+		capacity += (((state->blocks[i].end - state->blocks[i].start) + AT_REACH_CHUNK - 1) / AT_REACH_CHUNK);
+
+	if((state->queue = (at_reach_range_t *)at_reach_map(capacity * sizeof(at_reach_range_t))))
+	{
+		state->queue_capacity = capacity;
+
+		for(i = 0; i < state->root_no; i++)
+		{
+			root = &(state->roots[i]);
+
+			for(start = root->start; start < root->end; start += AT_REACH_CHUNK)
+			{
+				state->queue[state->queue_length].start = start;
+				state->queue[(state->queue_length)++].end =
+					(((root->end - start) > AT_REACH_CHUNK) ? (start + AT_REACH_CHUNK) : root->end);
+			}
+		}
+	}
+	else state->done = (char)1;
+
+	for(i = 0; i < created; i++) sem_post(&reach_start);
+	at_reach_work();
+	at_reach_resume(generation);
+
+	for(i = 0; i < created; i++) pthread_join(workers[i], NULL);
+
+	if(state->queue)
+	{
+		at_reach_report(stopped, signaled);
+		for(i = 0; i < state->length; i++) unreachable += !(state->marks[i]);
+	}
+	else fprintf(stderr, "[reach] failed to map the mark queue\n");
+
+	reach_state = NULL;
+	if(state->roots) munmap(state->roots, (state->root_capacity * sizeof(at_reach_range_t)));
+	if(state->queue) munmap(state->queue, (state->queue_capacity * sizeof(at_reach_range_t)));
+	if(state->maps) munmap(state->maps, (state->map_capacity * sizeof(at_reach_range_t)));
+	munmap(state->marks, blocks);
+	munmap(state->blocks, (blocks * sizeof(at_reach_block_t)));
+	munmap(state, sizeof(at_reach_t));
+	AT_UNLOCK();
+	return (int)unreachable;
+}
+
+/* the pages of the range resident in memory, queried in pieces so that
+   the vector stays on the stack */
+static size_t at_resident_pages(void *pointer, size_t size)
+{
+	unsigned char vector[256];
+	uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+	uintptr_t start = ((uintptr_t)pointer & ~(page - 1));
+	uintptr_t end = (((uintptr_t)pointer + size + page - 1) & ~(page - 1));
+	size_t pages = 0, count = 0, i = 0;
+
+	for(; start < end; start += (pages * page))
+	{
+		pages = ((end - start) / page);
+		if(pages > sizeof(vector)) pages = sizeof(vector);
+		if(mincore((void *)start, (pages * page), vector) != 0) break;
+		for(i = 0; i < pages; i++) count += (vector[i] & 1);
+	}
+
+	return count;
+}
+
+static int at_fault_open(pid_t tid, char major, char user)
+{
+	struct perf_event_attr attr;
+
+	memset(&attr, '\0', sizeof(struct perf_event_attr));
+	attr.size = sizeof(struct perf_event_attr);
+	attr.type = PERF_TYPE_SOFTWARE;
+	attr.config = (major ? PERF_COUNT_SW_PAGE_FAULTS_MAJ : PERF_COUNT_SW_PAGE_FAULTS_MIN);
+	attr.sample_period = fault_period;
+	attr.sample_type = PERF_SAMPLE_ADDR;
+	attr.exclude_kernel = (user ? 1 : 0);
+	attr.exclude_hv = 1;
+	return (int)syscall(SYS_perf_event_open, &attr, tid, -1, -1, PERF_FLAG_FD_CLOEXEC);
+}
+
+/* one minor and one major fault event for every thread running now, as
+   inherited events can not be mapped; faults the kernel takes on behalf
+   of the process, e.g. in "read", are only seen where permitted */
+static void at_fault_attach(void)
+{
+	at_fault_event_t *event = NULL;
+	struct dirent *entry = NULL;
+	DIR *tasks = opendir("/proc/self/task");
+	size_t length = ((1 + AT_FAULT_PAGES) * (size_t)sysconf(_SC_PAGESIZE));
+	char major = (char)0, user = (char)0;
+	pid_t tid = 0;
+
+	while(tasks && (entry = readdir(tasks)))
+	{
+		if(!(tid = (pid_t)strtol(entry->d_name, NULL, 10))) continue;
+
+		for(major = (char)0; (major < 2) && (fault_event_no < AT_FAULT_EVENTS); major++)
+		{
+			event = &(fault_events[fault_event_no]);
+			if(((event->fd = at_fault_open(tid, major, user)) < 0) && !user &&
+			   ((errno == EACCES) || (errno == EPERM)))
+				event->fd = at_fault_open(tid, major, (user = (char)1));
+			if(event->fd < 0) continue;
+
+			event->ring = mmap(NULL, length, (PROT_READ | PROT_WRITE), MAP_SHARED, event->fd, 0);
+
+			if(event->ring == MAP_FAILED)
+			{
+				close(event->fd);
+				continue;
+			}
+
+			event->major = major;
+			++fault_event_no;
+		}
+	}
+
+	if(tasks) closedir(tasks);
+}
+
+static void at_fault_copy(void *target, const unsigned char *data, uint64_t size,
+	uint64_t offset, size_t length)
+{
+	size_t i = 0;
+
+	for(i = 0; i < length; i++)
+		((unsigned char *)target)[i] = data[((offset + i) & (size - 1))];
+}
+
+/* the addresses sampled since the last call, records may wrap around
+   the end of the ring */
+static size_t at_fault_drain(at_fault_event_t *event, uint64_t *addresses,
+	char *majors, size_t length, size_t *lost)
+{
+	struct perf_event_mmap_page *page = (struct perf_event_mmap_page *)(event->ring);
+	const unsigned char *data = ((const unsigned char *)(event->ring) + sysconf(_SC_PAGESIZE));
+	uint64_t size = (AT_FAULT_PAGES * (uint64_t)sysconf(_SC_PAGESIZE));
+	uint64_t head = __atomic_load_n(&(page->data_head), __ATOMIC_ACQUIRE);
+	uint64_t tail = page->data_tail, value[2];
+	struct perf_event_header header;
+
+	while(tail < head)
+	{
+		at_fault_copy(&header, data, size, tail, sizeof(struct perf_event_header));
+		if(!(header.size)) break;
+
+		if(header.type == PERF_RECORD_SAMPLE)
+		{
+			if(length < AT_FAULT_SAMPLES)
+			{
+				at_fault_copy(&(addresses[length]), data, size,
+				              (tail + sizeof(struct perf_event_header)), sizeof(uint64_t));
+				majors[length++] = event->major;
+			}
+			else ++(*lost);
+		}
+		else if(header.type == PERF_RECORD_LOST)
+		{
+			at_fault_copy(value, data, size, (tail + sizeof(struct perf_event_header)),
+			              sizeof(value));
+			*lost += (size_t)(value[1]);
+		}
+
+		tail += header.size;
+	}
+
+	__atomic_store_n(&(page->data_tail), tail, __ATOMIC_RELEASE);
+	return length;
+}
+
+/* samples are attributed to the large blocks live when they are drained,
+   found by a binary search over the blocks ordered by address */
+static void at_fault_attribute(const uint64_t *addresses, const char *majors, size_t length)
+{
+	at_heap_list_item_t *item = NULL;
+	at_reach_block_t *blocks = NULL;
+	size_t count = 0, i = 0, low = 0, high = 0;
+
+	for(item = (heap_list ? (at_heap_list_item_t *)(heap_list->first) : NULL); item; item = item->next)
+		count += (item->pointer && (item->size >= AT_FAULT_MIN_BLOCK));
+	for(i = 0; i < compact.length; i++)
+		count += ((compact.records[i].word & AT_COMPACT_ADDRESS) &&
+		          (at_compact_size(&(compact.records[i])) >= AT_FAULT_MIN_BLOCK));
+
+	if(count && !(blocks = (at_reach_block_t *)at_meta_malloc(count * sizeof(at_reach_block_t)))) return;
+	count = 0;
+
+	for(item = (heap_list ? (at_heap_list_item_t *)(heap_list->first) : NULL); item; item = item->next)
+	{
+		if(!(item->pointer) || (item->size < AT_FAULT_MIN_BLOCK)) continue;
+		blocks[count].start = (uintptr_t)(item->pointer);
+		blocks[count].end = ((uintptr_t)(item->pointer) + (size_t)(item->size));
+		blocks[count++].site = item->site;
+	}
+
+	for(i = 0; i < compact.length; i++)
+	{
+		if(!(compact.records[i].word & AT_COMPACT_ADDRESS) ||
+		   (at_compact_size(&(compact.records[i])) < AT_FAULT_MIN_BLOCK)) continue;
+		blocks[count].start = (uintptr_t)at_compact_pointer(&(compact.records[i]));
+		blocks[count].end = (blocks[count].start + at_compact_size(&(compact.records[i])));
+		blocks[count++].site = at_compact_site(&(compact.records[i]));
+	}
+
+	if(count) qsort(blocks, count, sizeof(at_reach_block_t), at_reach_block_compare);
+
+	for(i = 0; i < length; i++)
+	{
+		for(low = 0, high = count; low < high;)
+		{
+			if(blocks[((low + high) / 2)].start <= addresses[i]) low = ((low + high) / 2) + 1;
+			else high = ((low + high) / 2);
+		}
+
+		if(!low || (addresses[i] >= blocks[(low - 1)].end) || !(blocks[(low - 1)].site))
+			fault_unattributed += fault_period;
+		else if(majors[i]) blocks[(low - 1)].site->fault_major += fault_period;
+		else blocks[(low - 1)].site->fault_minor += fault_period;
+	}
+
+	at_meta_free_null(blocks);
+}
+
+/* without sampling, pages found resident for the first time in a large
+   block are counted as touched for its site; compact records have no room
+   for that count, so the pages their blocks hold beyond those found at the
+   last probe are counted per site instead */
+static void at_fault_probe(void)
+{
+	at_heap_list_item_t *item = NULL;
+	at_site_t *site = NULL;
+	size_t resident = 0, i = 0;
+
+	for(item = (heap_list ? (at_heap_list_item_t *)(heap_list->first) : NULL); item; item = item->next)
+	{
+		if(!(item->pointer) || (item->size < AT_FAULT_MIN_BLOCK)) continue;
+		resident = at_resident_pages(item->pointer, (size_t)(item->size));
+		if(resident <= item->touched) continue;
+		if(item->site) item->site->fault_touched += (resident - item->touched);
+		item->touched = resident;
+	}
+
+	for(i = 0; i < site_table.length; i++) site_table.sites[i]->fault_probed = 0;
+
+	for(i = 0; i < compact.length; i++)
+	{
+		if(!(compact.records[i].word & AT_COMPACT_ADDRESS) ||
+		   (at_compact_size(&(compact.records[i])) < AT_FAULT_MIN_BLOCK)) continue;
+		site = at_compact_site(&(compact.records[i]));
+		site->fault_probed += at_resident_pages(at_compact_pointer(&(compact.records[i])),
+		                                        at_compact_size(&(compact.records[i])));
+	}
+
+	for(i = 0; i < site_table.length; i++)
+	{
+		site = site_table.sites[i];
+		if(site->fault_probed > site->fault_resident)
+			site->fault_touched += (site->fault_probed - site->fault_resident);
+		site->fault_resident = site->fault_probed;
+	}
+}
+
+static void at_fault_tick(void)
+{
+	uint64_t addresses[AT_FAULT_SAMPLES];
+	char majors[AT_FAULT_SAMPLES];
+	size_t i = 0, length = 0, lost = 0;
+
+	for(i = 0; i < fault_event_no; i++)
+		length = at_fault_drain(&(fault_events[i]), addresses, majors, length, &lost);
+
+	AT_LOCK();
+
+	if(!fault_event_no) at_fault_probe();
+	else if(length) at_fault_attribute(addresses, majors, length);
+
+	fault_lost += (lost * fault_period);
+	AT_UNLOCK();
+}
+
+static void *at_fault_run(void *unused)
+{
+	struct timespec until;
+
+	(void)unused;
+	clock_gettime(CLOCK_MONOTONIC, &until);
+	pthread_mutex_lock(&fault_lock);
+
+	while(!fault_stopping)
+	{
+		at_deadline_advance(&until, fault_interval);
+
+		while(!fault_stopping &&
+		      (pthread_cond_timedwait(&fault_wake, &fault_lock, &until) != ETIMEDOUT));
+
+		if(fault_stopping) break;
+		at_fault_tick();
+	}
+
+	pthread_mutex_unlock(&fault_lock);
+	return NULL;
+}
+
+/* samples every "period"-th page fault of the threads running now, and
+   attributes the samples to the large blocks, and their sites, every
+   "interval" milliseconds; if the events can not be opened, the blocks
+   are probed with "mincore" instead, and 1 is returned */
+int at_fault_start(unsigned int period, unsigned int interval)
+{
+	if(!period || !interval) return -1;
+	pthread_mutex_lock(&fault_control);
+
+	if(fault_interval)
+	{
+		pthread_mutex_unlock(&fault_control);
+		return (fault_event_no ? 0 : 1);
+	}
+
+	AT_LOCK();
+	if(!can_record) at_track_stats_init();
+	AT_UNLOCK();
+
+	fault_period = period;
+	at_fault_attach();
+	if(!fault_event_no) fault_period = 0;
+
+	fault_interval = interval;
+	fault_stopping = (char)0;
+	at_wake_init(&fault_wake);
+
+	if(pthread_create(&fault_thread, NULL, at_fault_run, NULL) != 0)
+	{
+		fprintf(stderr, "[fault] failed to start page fault thread\n");
+		at_fault_close();
+		fault_interval = 0;
+		pthread_mutex_unlock(&fault_control);
+		return -1;
+	}
+
+	pthread_mutex_unlock(&fault_control);
+	return (fault_event_no ? 0 : 1);
+}
+
+/* the samples left in the rings are attributed before the events close */
+void at_fault_stop(void)
+{
+	pthread_mutex_lock(&fault_control);
+
+	if(!fault_interval)
+	{
+		pthread_mutex_unlock(&fault_control);
+		return;
+	}
+
+	pthread_mutex_lock(&fault_lock);
+	fault_stopping = (char)1;
+	pthread_cond_signal(&fault_wake);
+	pthread_mutex_unlock(&fault_lock);
+	pthread_join(fault_thread, NULL);
+
+	at_fault_tick();
+	at_fault_close();
+	fault_interval = 0;
+	pthread_mutex_unlock(&fault_control);
+}
+
+static void *at_heap_track(void *pointer, size_t length, size_t alignment,
+	const char *filename, const char *function, int line)
+{
+	at_heap_list_item_t *item = NULL;
+
+	if(!pointer) return NULL;
+
+	AT_LOCK();
+
+	if(!at_compact_add(pointer, length, at_site_get(filename, function, line)))
+	{
+		item = at_heap_list_item_new(filename, function, line);
+		item->pointer = pointer;
+		item->size = length;
+		item->alignment = alignment;
+		at_list_add(heap_list, (at_list_item_t *)item, AT_LIST_TYPE_HEAP);
+	}
+
+	AT_UNLOCK();
+	return pointer;
+}
+
+void *at_malloc(size_t length, const char *filename,
+	const char *function, int line)
+{
+	at_heap_list_item_t *item = NULL;
+	void *pointer = NULL;
+	uint64_t start = at_meta_clock();
+
+	if(!length || (((signed long)length) < 0))
+	{
+		fprintf(stderr,
+			"[heap] invalid allocation request for %ld bytes detected\n",
+			((signed long)length));
+		return NULL;
+	}
+
+	if(compact_enabled)
+	{
+		pointer = at_heap_track(malloc(length), length, 0, filename, function, line);
+		at_meta_time(&(meta_stats.alloc), start);
+		return pointer;
+	}
+
+	AT_LOCK();
+	item = at_heap_list_item_new(filename, function, line);
+	item->pointer = (void *)malloc(length);
+	if(item->pointer) item->size = length;
+	else item->size = (long)(-1);
+	pointer = item->pointer;
+	at_list_add(heap_list, (at_list_item_t *)item, AT_LIST_TYPE_HEAP);
+	AT_UNLOCK();
+	at_meta_time(&(meta_stats.alloc), start);
+	return pointer;
+}
+
+void *at_calloc(size_t blocks, size_t length, const char *filename,
+	const char *function, int line)
+{
+	at_heap_list_item_t *item = NULL;
+	void *pointer = NULL;
+	uint64_t start = at_meta_clock();
+
+	if(!blocks || !length ||
+		 (((signed long)blocks) < 0) ||
+	   (((signed long)length) < 0))
+	{
+		fprintf(stderr,
+			"[heap] invalid allocation request for %ld bytes detected\n",
+			(((signed long)blocks) * ((signed long)length)));
+		return NULL;
+	}
+
+	if(compact_enabled)
+	{
+		pointer = at_heap_track(calloc(blocks, length), (blocks * length), 0,
+		                        filename, function, line);
+		at_meta_time(&(meta_stats.alloc), start);
+		return pointer;
+	}
+
+	AT_LOCK();
+	item = at_heap_list_item_new(filename, function, line);
+	item->pointer = (void *)calloc(blocks, length);
+	item->zeroed = (char)1;
+	if(item->pointer) item->size = (blocks * length);
+	else item->size = (long)(-1);
+	pointer = item->pointer;
+	at_list_add(heap_list, (at_list_item_t *)item, AT_LIST_TYPE_HEAP);
+	AT_UNLOCK();
+	at_meta_time(&(meta_stats.alloc), start);
+	return pointer;
+}
+
+static void *at_realloc_track(void *ptr, size_t length, const char *filename,
+	const char *function, int line)
+{
+	at_heap_list_item_t *item = NULL;
+	at_site_t *site = NULL;
+	uintptr_t address = (uintptr_t)ptr;
+	size_t size = 0, position = 0;
+	void *pointer = NULL;
+
+	if(((signed long)length) <= 0)
+	{
+		fprintf(stderr,
+			"[heap] invalid allocation request for %ld bytes detected\n",
+			((signed long)length));
+	}
+
+	AT_LOCK();
+
+	/* a compact record keeps its position, "realloc" to 0 bytes frees */
+	if((position = at_compact_find(ptr)) != (size_t)(-1))
+	{
+		if(!length) at_compact_remove(position, (char)1);
+		else if((pointer = (void *)realloc(ptr, length)) &&
+		        !at_compact_move(position, pointer, length, at_site_get(filename, function, line)))
+			at_heap_track(pointer, length, 0, filename, function, line);
+
+		AT_UNLOCK();
+		return pointer;
+	}
+
+	item = (at_heap_list_item_t *)at_list_get(heap_list, ptr);
+
+	if(!item)
+	{
+		AT_UNLOCK();
+		return NULL;
+	}
+
+	/* a block allocated with "new" is never resized, that would lose its kind */
+	if(item->kind != AT_ALLOC_KIND_MALLOC)
+	{
+		fprintf(stderr,
+			"[heap] block of %ld bytes allocated with \"%s\" at %s:%d passed to \"realloc\"\n",
+			item->size, at_alloc_kind_name(item->kind, (char)0),
+			at_basename(item->filename), item->line);
+		AT_UNLOCK();
+		return NULL;
+	}
+
+	/* like the compact records above, "realloc" to 0 bytes frees */
+	if(!length)
+	{
+		at_free(ptr);
+		AT_UNLOCK();
+		return NULL;
+	}
+
+	/* a failed "realloc" leaves the block, and its attribution, as it was */
+	at_index_erase(heap_list->index, (at_list_item_t *)item, ptr, AT_LIST_TYPE_HEAP);
+
+	if(!(pointer = (void *)realloc(ptr, length)))
+	{
+		at_list_index(heap_list, (at_list_item_t *)item);
+		AT_UNLOCK();
+		return NULL;
+	}
+
+	site = at_site_get(filename, function, line);
+	size = at_heap_item_size(item);
+	item->pointer = pointer;
+	item->size = length;
+	item->alignment = 0;
+	if((uintptr_t)pointer != address) item->touched = 0;
+	if(length > size) item->zeroed = (char)0;
+	at_list_index(heap_list, (at_list_item_t *)item);
+
+	/* the block now belongs to the site, and scope, of the "realloc" call */
+	at_scope_release(item->scope, size);
+	item->scope = at_scope_current();
+	at_scope_acquire(item->scope, at_heap_item_size(item));
+	at_site_release(item->site, size);
+	at_site_acquire(site, at_heap_item_size(item));
+	at_site_realloc(site, item, size, at_heap_item_size(item),
+		(char)((uintptr_t)pointer != address));
+
+	/* resizing a block in another thread hands it over from its old site */
+	if(item->thread != at_thread_self())
+	{
+		at_site_free_thread(item->site, item->thread, at_thread_self(), (char)1);
+		item->thread = at_thread_self();
+	}
+
+	item->site = site;
+
+	at_list_item_set_origin((at_list_item_t *)item, filename, function, line);
+	at_shm_update(site);
+	ptr = item->pointer;
+	AT_UNLOCK();
+
+	return ptr;
+}
+
+void *at_realloc(void *ptr, size_t length, const char *filename,
+	const char *function, int line)
+{
+	void *pointer = NULL;
+	uint64_t start = 0;
+
+	if(!ptr) return at_malloc(length, filename, function, line);
+
+	start = at_meta_clock();
+	pointer = at_realloc_track(ptr, length, filename, function, line);
+	at_meta_time(&(meta_stats.alloc), start);
+	return pointer;
+}
+
+#if defined _XOPEN_SOURCE && _XOPEN_SOURCE >= 500 \
+ || defined _POSIX_C_SOURCE && _POSIX_C_SOURCE >= 200809L \
+ || defined _BSC_SOURCE || defined _SVID_SOURCE
+char *at_strdup(const char *string, const char *filename,
+	const char *function, int line)
+{
+	at_heap_list_item_t *item = NULL;
+	char *pointer = NULL;
+	uint64_t start = at_meta_clock();
+
+	if(!string) return NULL;
+	if(!strlen(string)) return NULL;
+
+	if(compact_enabled)
+	{
+		if((pointer = (char *)malloc((strlen(string) + 1) * sizeof(char)))) strcpy(pointer, string);
+		pointer = (char *)at_heap_track(pointer, (strlen(string) + 1), 0, filename, function, line);
+		at_meta_time(&(meta_stats.alloc), start);
+		return pointer;
+	}
+
+	AT_LOCK();
+	item = at_heap_list_item_new(filename, function, line);
+	pointer = (char *)malloc((strlen(string) + 1) * sizeof(char));
+
+	if(pointer)
+	{
+		strcpy(pointer, string);
+		item->size = (strlen(pointer) + 1);
+	}
+
+	item->pointer = pointer;
+	at_list_add(heap_list, (at_list_item_t *)item, AT_LIST_TYPE_HEAP);
+	AT_UNLOCK();
+	at_meta_time(&(meta_stats.alloc), start);
+	return pointer;
+}
+#endif
+
+#if defined __USE_XOPEN2K8 || __GLIBC_USE(LIB_EXT2) \
+ || defined _POSIX_C_SOURCE && _POSIX_C_SOURCE >= 200809L \
+ || defined _XOPEN_SOURCE && _XOPEN_SOURCE >= 700 \
+ || defined _GNU_SOURCE
+static void at_getdelim_grow(at_heap_list_item_t *item, size_t nsize, char moved,
+	const char *filename, const char *function, int line)
+{
+	size_t size = at_heap_item_size(item);
+
+	/* unlike "realloc" the block keeps its origin, only the growth
+	   is recorded for the site of the "getline" call */
+	at_site_grow(item->site, (nsize - size));
+
+	if(item->scope)
+	{
+		item->scope->live_amount += (nsize - size);
+
+		if(item->scope->live_amount > item->scope->peak_amount)
+			item->scope->peak_amount = item->scope->live_amount;
+	}
+
+	at_site_realloc(at_site_get(filename, function, line), item, size, nsize, moved);
+	at_shm_update(item->site);
+}
+
+size_t at_getline(char **outline, size_t *buflen, FILE *stream,
+	const char *filename, const char *function, int line)
+{
+	return at_getdelim(outline, buflen, '\n', stream,
+	                   filename, function, line);
+}
+
+size_t at_getdelim(char **outline, size_t *buflen, int delim, FILE *stream,
+	const char *filename, const char *function, int line)
+{
+	at_heap_list_item_t *item = NULL;
+	size_t nbuflen = *buflen, linelen = 0, position = 0;
+	char *preallocated = NULL;
+	int error = errno;
+
+	if(!outline || !buflen || !stream) return (size_t)(-1);
+
+	/* the lock is not held while reading, as reading may block, and
+	   "errno" is only meaningful if the call itself changed it; the
+	   caller's value is left alone unless the call failed */
+	if(!(*outline)/* && !(*buflen)*/)
+	{
+		if(delim == '\n') linelen = getline(outline, buflen, stream);
+		else linelen = getdelim(outline, buflen, delim, stream);
+
+    if((linelen == (size_t)(-1)) && (errno != error) &&
+       ((errno == EINVAL) || (errno == ENOMEM)))
+      return linelen;
+
+		if(linelen == (size_t)(-1)) error = errno;
+
+		at_heap_track(*outline, *buflen, 0, filename, function, line);
+	}
+	else
+	{
+		preallocated = *outline;
+
+		if(delim == '\n') linelen = getline(outline, &nbuflen, stream);
+		else linelen = getdelim(outline, &nbuflen, delim, stream);
+
+    if((linelen == (size_t)(-1)) && (errno != error) &&
+       ((errno == EINVAL) || (errno == ENOMEM)))
+      return linelen;
+
+		if(linelen == (size_t)(-1)) error = errno;
+
+		if(nbuflen > *buflen)
+		{
+			AT_LOCK();
+
+			/* a compact record keeps its origin like an item, it is found
+			   by the address the buffer had before */
+			if((position = at_compact_find((void *)preallocated)) != (size_t)(-1))
+			{
+				if(!at_compact_move(position, (void *)(*outline), nbuflen,
+				                    at_compact_site(&(compact.records[position]))))
+					at_heap_track(*outline, nbuflen, 0, filename, function, line);
+			}
+			else if((item = (at_heap_list_item_t *)at_list_get(heap_list, (void *)(*outline))))
+			{
+				at_getdelim_grow(item, nbuflen, (char)0, filename, function, line);
+				item->size = nbuflen;
+			}
+			else
+			{
+				item = (at_heap_list_item_t *)at_list_get(heap_list, (void *)preallocated);
+
+				if(item) /* ((preallocated != *outline) == true) implicitly holds */
+				{
+					at_getdelim_grow(item, nbuflen, (char)1, filename, function, line);
+					item->pointer = *outline;
+					item->size = nbuflen;
+					at_list_rekey(heap_list, (at_list_item_t *)item, (void *)preallocated);
+          /* "preallocated" has already been freed by "realloc"
+             inside "getline", or "getdelim", respectively */
+				}
+				/* else: buffer is not allocated on heap but on stack */
+			}
+
+			AT_UNLOCK();
+			*buflen = nbuflen;
+		}
+	}
+
+	errno = error;
+	return linelen;
+}
+#endif
+
+void at_free(void *pointer)
+{
+	at_heap_list_item_t *item = NULL;
+	size_t position = 0;
+	uint64_t start = 0;
+
+	if(!pointer) return;
+	start = at_meta_clock();
+
+	AT_LOCK();
+
+	if((position = at_compact_find(pointer)) != (size_t)(-1))
+		at_compact_remove(position, (char)1);
+	else
+	{
+		if((item = (at_heap_list_item_t *)at_list_get(heap_list, pointer)))
+		{
+			if(item->kind != AT_ALLOC_KIND_MALLOC)
+				at_heap_item_mismatch(item, AT_ALLOC_KIND_MALLOC);
+
+			at_site_free_thread(item->site, item->thread, at_thread_self(), (char)0);
+		}
+
+		at_list_remove(heap_list, pointer);
+	}
+
+	AT_UNLOCK();
+	at_meta_time(&(meta_stats.free), start);
+}
+
+void *at_new(size_t length, size_t alignment, at_alloc_kind_t kind, void *address,
+	const char *filename, const char *function, int line)
+{
+	at_heap_list_item_t *item = NULL;
+	at_caller_t *caller = NULL;
+	void *pointer = NULL;
+	uint64_t start = at_meta_clock();
+
+	AT_LOCK();
+
+	if(!filename && address)
+	{
+		caller = at_caller_resolve(address);
+		filename = caller->filename;
+		function = caller->function;
+		line = caller->line;
+	}
+
+	/* the aligned forms are only used beyond the alignment of "malloc" */
+	if(alignment)
+	{
+		if(posix_memalign(&pointer, alignment, (length ? length : 1))) pointer = NULL;
+	}
+	else pointer = malloc(length);
+
+	if(!pointer)
+	{
+		AT_UNLOCK();
+		return NULL;
+	}
+
+	item = at_heap_list_item_new(filename, function, line);
+	item->pointer = pointer;
+	item->size = (long)length;
+	item->alignment = alignment;
+	item->kind = kind;
+	at_list_add(heap_list, (at_list_item_t *)item, AT_LIST_TYPE_HEAP);
+	AT_UNLOCK();
+	at_meta_time(&(meta_stats.alloc), start);
+	return pointer;
+}
+
+/* a block is looked up like one passed to "free", so nothing but the
+   pointer itself is read from a block the tracker does not know; "length"
+   is the size passed to a sized "delete", or 0, and "alignment" the one
+   passed to an aligned "delete", or 0 */
+void at_delete(void *pointer, size_t length, size_t alignment, at_alloc_kind_t kind)
+{
+	at_heap_list_item_t *item = NULL;
+	uint64_t start = 0;
+
+	(void)alignment;
+	if(!pointer) return;
+	start = at_meta_clock();
+	AT_LOCK();
+
+	if(!(item = (at_heap_list_item_t *)at_list_get(heap_list, pointer)))
+	{
+		if(!can_record) at_track_stats_init();
+		++(stats.untracked_no);
+
+		/* blocks allocated with "new" before the tracker was shut down
+		   are no longer known, they are released silently */
+		if(!new_orphans)
+			fprintf(stderr, "[heap] untracked block %p released with \"%s\"\n",
+				pointer, at_alloc_kind_name(kind, (char)1));
+
+		free(pointer);
+
+		AT_UNLOCK();
+		at_meta_time(&(meta_stats.free), start);
+		return;
+	}
+
+	if(item->kind != kind) at_heap_item_mismatch(item, kind);
+	else if(length && (length != (size_t)(item->size)))
+	{
+		++(stats.mismatch_no);
+		fprintf(stderr,
+			"[heap] sized \"%s\" of %lu bytes for block of %ld bytes allocated at %s:%d\n",
+			at_alloc_kind_name(kind, (char)1), (unsigned long)length, item->size,
+			at_basename(item->filename), item->line);
+	}
+
+	at_site_free_thread(item->site, item->thread, at_thread_self(), (char)0);
+	at_list_unlink(heap_list, (at_list_item_t *)item);
+	at_track_stats_release((at_list_item_t *)item, AT_LIST_TYPE_HEAP);
+	at_list_free_item((at_list_item_t **)&item, AT_LIST_TYPE_HEAP);
+	AT_UNLOCK();
+	at_meta_time(&(meta_stats.free), start);
+}
+
+FILE *at_fopen(const char *name, const char *mode, const char *filename,
+	const char *function, int line)
+{
+	at_file_list_item_t *item = NULL;
+	FILE *handle = NULL;
+
+	if(!name || !strlen(name)) return NULL;
+	if(!mode || !strlen(mode)) return NULL;
+
+	/* opening a FIFO blocks, so the lock is taken afterwards */
+	handle = fopen(name, mode);
+
+	AT_LOCK();
+	item = at_file_list_item_new(filename, function, line);
+	item->handle = handle;
+	item->name = (char *)at_meta_malloc((strlen(name) + 1) * sizeof(char));
+	strcpy(item->name, name);
+	item->mode = (char *)at_meta_malloc((strlen(mode) + 1) * sizeof(char));
+	strcpy(item->mode, mode);
+	at_list_add(file_list, (at_list_item_t *)item, AT_LIST_TYPE_FILE);
+	AT_UNLOCK();
+	return handle;
+}
+
+FILE *at_freopen(char *name, const char *mode, FILE *stream,
+	const char *filename, const char *function, int line)
+{
+	at_file_list_item_t *item = NULL;
+	FILE *tmphandle = NULL;
+
+	if(!mode || !strlen(mode)) return NULL;
+	if(!stream) return NULL;
+
+	AT_LOCK();
+	item = (at_file_list_item_t *)at_list_get(file_list, (void *)stream);
+
+	if(item)
+	{
+		if(!name) name = item->name;
+
+		if(item->name && !strcmp(item->name, name))
+		{
+			if(strcmp(item->mode, mode))
+			{
+				at_meta_free_null(item->mode);
+				item->mode = (char *)at_meta_malloc((strlen(mode) + 1) * sizeof(char));
+				strcpy(item->mode, mode);
+			}
+		}
+		else
+		{
+			at_list_remove(file_list, (void *)stream);
+			item = NULL;
+		}
+	}
+
+	if(!item)
+	{
+		item = at_file_list_item_new(filename, function, line);
+
+		if(name)
+		{
+			item->name = (char *)at_meta_malloc((strlen(name) + 1) * sizeof(char));
+			strcpy(item->name, name);
+		}
+		else item->name = NULL;
+
+		item->mode = (char *)at_meta_malloc((strlen(mode) + 1) * sizeof(char));
+		strcpy(item->mode, mode);
+
+		if((item->handle = freopen(name, mode, stream)))
+			at_list_add(file_list, (at_list_item_t *)item, AT_LIST_TYPE_FILE);
+		else
+		{
+			at_track_stats_release((at_list_item_t *)item, AT_LIST_TYPE_FILE);
+			at_list_free_item((at_list_item_t **)&item, AT_LIST_TYPE_FILE);
+		}
+	}
+	else
+	{
+		tmphandle = freopen(name, mode, stream);
+
+		if(tmphandle && (tmphandle != (item->handle)))
+		{
+			at_list_remove(file_list, (void *)(item->handle));
+
+			item = at_file_list_item_new(filename, function, line);
+
+			if(name)
+			{
+				item->name = (char *)at_meta_malloc((strlen(name) + 1) * sizeof(char));
+				strcpy(item->name, name);
+			}
+			else item->name = NULL;
+
+			item->mode = (char *)at_meta_malloc((strlen(mode) + 1) * sizeof(char));
+			strcpy(item->mode, mode);
+
+			item->handle = tmphandle;
+
+			at_list_add(file_list, (at_list_item_t *)item, AT_LIST_TYPE_FILE);
+		}
+		else
+		{
 			if(!tmphandle)
 			{
-				if(item->handle)
-					at_list_remove(file_list, (void *)(item->handle));
-				else
+				if(item->handle)
+					at_list_remove(file_list, (void *)(item->handle));
+				else
+				{
+					at_track_stats_release((at_list_item_t *)item, AT_LIST_TYPE_FILE);
+					at_list_free_item((at_list_item_t **)&item, AT_LIST_TYPE_FILE);
+				}
+
+				item = NULL;
+			}
+			else item->handle = tmphandle;
+		}
+	}
+
+	tmphandle = (item ? item->handle : NULL);
+	AT_UNLOCK();
+	return tmphandle;
+}
+
+FILE *at_tmpfile(const char *filename, const char *function, int line)
+{
+	at_file_list_item_t *item = NULL;
+	FILE *handle = NULL;
+
+	AT_LOCK();
+	item = at_file_list_item_new(filename, function, line);
+
+	if(!item)
+	{
+		AT_UNLOCK();
+		return NULL;
+	}
+
+	handle = item->handle = tmpfile();
+	item->name = NULL;
+	item->mode = at_meta_strdup("wb+");
+	at_list_add(file_list, (at_list_item_t *)item, AT_LIST_TYPE_FILE);
+	AT_UNLOCK();
+
+	return handle;
+}
+
+void at_fclose(FILE *file)
+{
+	if(!file) return;
+	AT_LOCK();
+	at_file_io_warn((at_file_list_item_t *)at_list_get(file_list, (void *)file));
+	at_list_remove(file_list, (void *)file);
+	AT_UNLOCK();
+}
+
+int at_stream_query(FILE *stream, at_stream_stats_t *stream_stats)
+{
+	at_file_list_item_t *item = NULL;
+
+	if(!stream || !stream_stats) return -1;
+	AT_LOCK();
+
+	if(!(item = (at_file_list_item_t *)at_list_get(file_list, (void *)stream)))
+	{
+		AT_UNLOCK();
+		return -1;
+	}
+
+	stream_stats->read_amount = item->read_amount;
+	stream_stats->read_no = item->read_no;
+	stream_stats->write_amount = item->write_amount;
+	stream_stats->write_no = item->write_no;
+	AT_UNLOCK();
+	return 0;
+}
+
+size_t at_fread(void *pointer, size_t size, size_t blocks, FILE *stream)
+{
+	at_file_list_item_t *item = NULL;
+	size_t result = fread(pointer, size, blocks, stream);
+
+	AT_LOCK();
+
+	if((item = (at_file_list_item_t *)at_list_get(file_list, (void *)stream)))
+	{
+		item->read_amount += (result * size);
+		++(item->read_no);
+	}
+
+	AT_UNLOCK();
+	return result;
+}
+
+size_t at_fwrite(const void *pointer, size_t size, size_t blocks, FILE *stream)
+{
+	at_file_list_item_t *item = NULL;
+	size_t result = fwrite(pointer, size, blocks, stream);
+
+	AT_LOCK();
+
+	if((item = (at_file_list_item_t *)at_list_get(file_list, (void *)stream)))
+	{
+		item->write_amount += (result * size);
+		++(item->write_no);
+	}
+
+	AT_UNLOCK();
+	return result;
+}
+
+char *at_fgets(char *string, int length, FILE *stream)
+{
+	at_file_list_item_t *item = NULL;
+	char *result = fgets(string, length, stream);
+
+	AT_LOCK();
+
+	if((item = (at_file_list_item_t *)at_list_get(file_list, (void *)stream)))
+	{
+		if(result) item->read_amount += strlen(result);
+		++(item->read_no);
+	}
+
+	AT_UNLOCK();
+	return result;
+}
+
+int at_fputs(const char *string, FILE *stream)
+{
+	at_file_list_item_t *item = NULL;
+	int result = fputs(string, stream);
+
+	AT_LOCK();
+
+	if((item = (at_file_list_item_t *)at_list_get(file_list, (void *)stream)))
+	{
+		if(result >= 0) item->write_amount += strlen(string);
+		++(item->write_no);
+	}
+
+	AT_UNLOCK();
+	return result;
+}
+
+int at_fprintf(FILE *stream, const char *format, ...)
+{
+	at_file_list_item_t *item = NULL;
+	va_list args;
+	int result = 0;
+
+	va_start(args, format);
+	result = vfprintf(stream, format, args);
+	va_end(args);
+
+	AT_LOCK();
+
+	if((item = (at_file_list_item_t *)at_list_get(file_list, (void *)stream)))
+	{
+		if(result > 0) item->write_amount += (size_t)result;
+		++(item->write_no);
+	}
+
+	AT_UNLOCK();
+	return result;
+}
+
+int at_setvbuf(FILE *stream, char *buffer, int mode, size_t size)
+{
+	at_file_list_item_t *item = NULL;
+	int result = setvbuf(stream, buffer, mode, size);
+
+	AT_LOCK();
+
+	if(!result && (item = (at_file_list_item_t *)at_list_get(file_list, (void *)stream)))
+	{
+		item->buffer_mode = mode;
+		item->buffer_size = ((mode == _IONBF) ? 0 : (size ? size : BUFSIZ));
+	}
+
+	AT_UNLOCK();
+	return result;
+}
+
+void *at_aligned_alloc(size_t alignment, size_t length, const char *filename,
+	const char *function, int line)
+{
+	void *pointer = NULL;
+	uint64_t start = at_meta_clock();
+
+	if(!length || (((signed long)length) < 0))
+	{
+		fprintf(stderr,
+			"[heap] invalid allocation request for %ld bytes detected\n",
+			((signed long)length));
+		return NULL;
+	}
+
+	pointer = at_heap_track(aligned_alloc(alignment, length), length,
+	                        alignment, filename, function, line);
+	at_meta_time(&(meta_stats.alloc), start);
+	return pointer;
+}
+
+void *at_memalign(size_t alignment, size_t length, const char *filename,
+	const char *function, int line)
+{
+	void *pointer = NULL;
+	uint64_t start = at_meta_clock();
+
+	if(!length || (((signed long)length) < 0))
+	{
+		fprintf(stderr,
+			"[heap] invalid allocation request for %ld bytes detected\n",
+			((signed long)length));
+		return NULL;
+	}
+
+	pointer = at_heap_track(memalign(alignment, length), length,
+	                        alignment, filename, function, line);
+	at_meta_time(&(meta_stats.alloc), start);
+	return pointer;
+}
+
+void *at_reallocarray(void *ptr, size_t blocks, size_t length,
+	const char *filename, const char *function, int line)
+{
+	if(blocks && (length > (((size_t)(-1)) / blocks)))
+	{
+		errno = ENOMEM;
+		return NULL;
+	}
+
+	return at_realloc(ptr, (blocks * length), filename, function, line);
+}
+
+#if defined __USE_XOPEN2K8 || __GLIBC_USE(LIB_EXT2) \
+ || defined _POSIX_C_SOURCE && _POSIX_C_SOURCE >= 200809L \
+ || defined _XOPEN_SOURCE && _XOPEN_SOURCE >= 700 \
+ || defined _GNU_SOURCE
+char *at_strndup(const char *string, size_t size, const char *filename,
+	const char *function, int line)
+{
+	char *pointer = NULL;
+	size_t length = 0;
+	uint64_t start = at_meta_clock();
+
+	if(!string) return NULL;
+
+	length = strnlen(string, size);
+	pointer = (char *)malloc((length + 1) * sizeof(char));
+	if(!pointer) return NULL;
+
+	memcpy(pointer, string, length);
+	pointer[length] = '\0';
+	at_heap_track(pointer, (length + 1), 0, filename, function, line);
+	at_meta_time(&(meta_stats.alloc), start);
+	return pointer;
+}
+#endif
+
+#if defined __STDC_VERSION__ && __STDC_VERSION__ >= 199901L
+int at_asprintf(const char *filename, const char *function, int line,
+	char **string, const char *format, ...)
+{
+	va_list args;
+	int length = 0;
+
+	if(!string || !format) return -1;
+
+	va_start(args, format);
+	length = vsnprintf(NULL, 0, format, args);
+	va_end(args);
+
+	if(length < 0) return length;
+	if(!(*string = (char *)malloc((length + 1) * sizeof(char)))) return -1;
+
+	va_start(args, format);
+	vsnprintf(*string, (length + 1), format, args);
+	va_end(args);
+
+	at_heap_track(*string, (length + 1), 0, filename, function, line);
+	return length;
+}
+#endif
+
+static size_t at_map_pagesize(int flags)
+{
+#if defined MAP_HUGETLB && defined MAP_HUGE_SHIFT
+	if(flags & MAP_HUGETLB)
+	{
+		if((flags >> MAP_HUGE_SHIFT) & MAP_HUGE_MASK)
+			return ((size_t)1 << ((flags >> MAP_HUGE_SHIFT) & MAP_HUGE_MASK));
+		return AT_HUGE_PAGE_SIZE;
+	}
+#else
+	(void)flags;
+#endif
+
+	return 0;
+}
+
+static size_t at_map_round(size_t length, size_t pagesize)
+{
+	if(!pagesize) pagesize = (size_t)sysconf(_SC_PAGESIZE);
+	return (((length + pagesize - 1) / pagesize) * pagesize);
+}
+
+static at_map_list_item_t *at_map_find(void *address)
+{
+	at_map_list_item_t *item = NULL;
+
+	if(!map_list) return NULL;
+
+	item = (at_map_list_item_t *)(map_list->first);
+
+	while(item)
+	{
+		if(((char *)address >= (char *)(item->pointer)) &&
+		   ((char *)address < ((char *)(item->pointer) + item->size)))
+			return item;
+		item = item->next;
+	}
+
+	return NULL;
+}
+
+/* forget the tracked part of all mappings overlapping the given range
+   (the range itself is already unmapped, or replaced, respectively) */
+static void at_map_release_range(void *address, size_t length)
+{
+	at_map_list_item_t *item = NULL, *tail = NULL, *next = NULL;
+	char *low = (char *)address, *high = ((char *)address + length);
+	char *start = NULL, *end = NULL;
+	size_t released = 0;
+
+	if(!map_list || !length) return;
+
+	item = (at_map_list_item_t *)(map_list->first);
+
+	while(item)
+	{
+		next = item->next;
+		start = (char *)(item->pointer);
+		end = (start + item->size);
+
+		if((low < end) && (high > start))
+		{
+			if((low <= start) && (high >= end))
+			{
+				released += item->size;
+				at_list_unlink(map_list, (at_list_item_t *)item);
+				item->pointer = NULL;
+				at_list_free_item((at_list_item_t **)&item, AT_LIST_TYPE_MAP);
+			}
+			else if(low <= start)
+			{
+				released += (size_t)(high - start);
+				item->pointer = high;
+				item->size = (size_t)(end - high);
+				at_list_rekey(map_list, (at_list_item_t *)item, start);
+			}
+			else
+			{
+				if(high < end)
 				{
-					at_track_stats_release((at_list_item_t *)item, AT_LIST_TYPE_FILE);
-					at_list_free_item((at_list_item_t **)&item, AT_LIST_TYPE_FILE);
+					tail = at_map_list_item_new(item->filename, item->function, item->line);
+					tail->pointer = high;
+					tail->size = (size_t)(end - high);
+					tail->prot = item->prot;
+					tail->flags = item->flags;
+					tail->fd = item->fd;
+					tail->pagesize = item->pagesize;
+
+					/* the tail is not a new mapping, only its bookkeeping is */
+					tail->prev = (at_map_list_item_t *)(map_list->last);
+					map_list->last->next = (at_list_item_t *)tail;
+					map_list->last = (at_list_item_t *)tail;
+					++(map_list->length);
+					at_list_index(map_list, (at_list_item_t *)tail);
 				}
+
+				released += (size_t)((high < end ? high : end) - low);
+				item->size = (size_t)(low - start);
 			}
-			else item->handle = tmphandle;
 		}
+
+		item = next;
 	}
 
-	return item->handle;
+	if(released)
+	{
+		map_stats.unmap_amount += released;
+		++(map_stats.unmap_no);
+	}
 }
 
-FILE *at_tmpfile(const char *filename, const char *function, int line)
+#if defined __USE_XOPEN2K \
+ || defined _POSIX_C_SOURCE && _POSIX_C_SOURCE >= 200112L
+void *at_mmap(void *address, size_t length, int prot, int flags, int fd,
+	off_t offset, const char *filename, const char *function, int line)
 {
-	at_file_list_item_t *item = at_file_list_item_new(filename, function, line);
+	at_map_list_item_t *item = NULL;
+	void *pointer = NULL;
 
-	if(!item) return NULL;
+	pointer = mmap(address, length, prot, flags, fd, offset);
+	if(pointer == MAP_FAILED) return pointer;
 
-	item->handle = tmpfile();
-	item->name = NULL;
-	item->mode = strdup("wb+");
-	at_list_add(file_list, (at_list_item_t *)item, AT_LIST_TYPE_FILE);
+	AT_LOCK();
 
-	return item->handle;
+	if(flags & MAP_FIXED)
+		at_map_release_range(pointer, at_map_round(length, at_map_pagesize(flags)));
+
+	item = at_map_list_item_new(filename, function, line);
+	item->pointer = pointer;
+	item->prot = prot;
+	item->flags = flags;
+	item->fd = ((flags & MAP_ANONYMOUS) ? -1 : fd);
+	item->pagesize = at_map_pagesize(flags);
+	item->size = at_map_round(length, item->pagesize);
+	at_list_add(map_list, (at_list_item_t *)item, AT_LIST_TYPE_MAP);
+	AT_UNLOCK();
+	return pointer;
 }
 
-void at_fclose(FILE *file)
+int at_munmap(void *address, size_t length)
 {
-	if(!file) return;
-	at_list_remove(file_list, (void *)file);
+	int result = 0;
+
+	/* unmapping and forgetting must not be interleaved with a new
+	   mapping at the same address by another thread */
+	AT_LOCK();
+	if(!(result = munmap(address, length)))
+		at_map_release_range(address, at_map_round(length, 0));
+	AT_UNLOCK();
+	return result;
+}
+
+int at_posix_memalign(void **pointer, size_t alignment, size_t length,
+	const char *filename, const char *function, int line)
+{
+	int result = 0;
+	uint64_t start = at_meta_clock();
+
+	if(!pointer) return EINVAL;
+
+	if(!length || (((signed long)length) < 0))
+	{
+		fprintf(stderr,
+			"[heap] invalid allocation request for %ld bytes detected\n",
+			((signed long)length));
+		return EINVAL;
+	}
+
+	if((result = posix_memalign(pointer, alignment, length))) return result;
+	at_heap_track(*pointer, length, alignment, filename, function, line);
+	at_meta_time(&(meta_stats.alloc), start);
+	return 0;
+}
+#endif
+
+#if defined __STDC_VERSION__ && __STDC_VERSION__ >= 199901L
+void *at_mremap(const char *filename, const char *function, int line,
+	void *address, size_t length, size_t nlength, int flags, ...)
+{
+	at_map_list_item_t *item = NULL, *origin = NULL;
+	void *pointer = NULL, *target = NULL;
+	size_t size = 0;
+	va_list args;
+
+	if(flags & MREMAP_FIXED)
+	{
+		va_start(args, flags);
+		target = va_arg(args, void *);
+		va_end(args);
+	}
+
+	AT_LOCK();
+	pointer = mremap(address, length, nlength, flags, target);
+
+	if(pointer == MAP_FAILED)
+	{
+		AT_UNLOCK();
+		return pointer;
+	}
+
+	item = (at_map_list_item_t *)at_list_get(map_list, address);
+
+	if(item && length && (item->size == at_map_round(length, item->pagesize)))
+	{
+		size = at_map_round(nlength, item->pagesize);
+
+		if(size > item->size)
+		{
+			map_stats.map_amount += (size - item->size);
+			if(item->pagesize) map_stats.huge_amount += (size - item->size);
+		}
+		else map_stats.unmap_amount += (item->size - size);
+
+		if((map_stats.map_amount - map_stats.unmap_amount) > map_stats.peak_amount)
+			map_stats.peak_amount = (map_stats.map_amount - map_stats.unmap_amount);
+
+		item->size = size;
+
+		if(pointer != address)
+		{
+			item->pointer = pointer;
+			at_list_rekey(map_list, (at_list_item_t *)item, address);
+		}
+
+		at_list_item_set_origin((at_list_item_t *)item, filename, function, line);
+		AT_UNLOCK();
+		return pointer;
+	}
+
+	item = at_map_list_item_new(filename, function, line);
+
+	if((origin = at_map_find(address)))
+	{
+		item->prot = origin->prot;
+		item->flags = origin->flags;
+		item->fd = origin->fd;
+		item->pagesize = origin->pagesize;
+	}
+
+	/* a zero "length" duplicates a shared mapping without unmapping it */
+	if(length)
+		at_map_release_range(address, at_map_round(length, item->pagesize));
+
+	item->pointer = pointer;
+	item->size = at_map_round(nlength, item->pagesize);
+	at_list_add(map_list, (at_list_item_t *)item, AT_LIST_TYPE_MAP);
+	AT_UNLOCK();
+	return pointer;
+}
+#endif
+
+#if defined __USE_XOPEN2K \
+ || defined _POSIX_C_SOURCE && _POSIX_C_SOURCE >= 200112L
+#if defined __STDC_VERSION__ && __STDC_VERSION__ >= 199901L
+int at_open(const char *filename, const char *function, int line,
+	const char *path, int flags, ...)
+{
+	mode_t mode = 0;
+	va_list args;
+
+	if((flags & O_CREAT) || ((flags & O_TMPFILE) == O_TMPFILE))
+	{
+		va_start(args, flags);
+		mode = (mode_t)va_arg(args, int);
+		va_end(args);
+	}
+
+	return at_fd_track(open(path, flags, mode), AT_FD_TYPE_FILE,
+	                   filename, function, line);
+}
+#endif
+
+int at_socket(int domain, int type, int protocol, const char *filename,
+	const char *function, int line)
+{
+	return at_fd_track(socket(domain, type, protocol), AT_FD_TYPE_SOCKET,
+	                   filename, function, line);
+}
+
+int at_accept(int sock, struct sockaddr *address, socklen_t *length,
+	const char *filename, const char *function, int line)
+{
+	return at_fd_track(accept(sock, address, length), AT_FD_TYPE_SOCKET,
+	                   filename, function, line);
+}
+
+int at_pipe(int *fds, const char *filename, const char *function, int line)
+{
+	int result = 0;
+
+	if((result = pipe(fds))) return result;
+	at_fd_track(fds[0], AT_FD_TYPE_PIPE, filename, function, line);
+	at_fd_track(fds[1], AT_FD_TYPE_PIPE, filename, function, line);
+	return result;
+}
+
+int at_dup(int fd, const char *filename, const char *function, int line)
+{
+	return at_fd_track(dup(fd), AT_FD_TYPE_DUP, filename, function, line);
+}
+
+int at_dup2(int fd, int nfd, const char *filename, const char *function, int line)
+{
+	int result = dup2(fd, nfd);
+
+	/* "dup2" silently closes "nfd" if it was open, but leaves it alone
+	   if both descriptors are the same */
+	if((result < 0) || (fd == nfd)) return result;
+	return at_fd_track(result, AT_FD_TYPE_DUP, filename, function, line);
+}
+
+int at_close(int fd)
+{
+	/* forget the descriptor before closing it, as another thread may
+	   be handed out the same number right after "close" returns */
+	at_fd_release(fd);
+	return close(fd);
+}
+#endif
+
+#ifdef __linux__
+int at_eventfd(unsigned int initval, int flags, const char *filename,
+	const char *function, int line)
+{
+	return at_fd_track(eventfd(initval, flags), AT_FD_TYPE_EVENT,
+	                   filename, function, line);
+}
+
+int at_epoll_create(int size, const char *filename, const char *function, int line)
+{
+	return at_fd_track(epoll_create(size), AT_FD_TYPE_EPOLL,
+	                   filename, function, line);
+}
+
+int at_epoll_create1(int flags, const char *filename, const char *function, int line)
+{
+	return at_fd_track(epoll_create1(flags), AT_FD_TYPE_EPOLL,
+	                   filename, function, line);
 }
+#endif
 
 char *at_version(void) { return ALLOC_TRACKER_VERSION; }
@@ -15,19 +15,22 @@
 #ifndef _AT_ALLOC_TRACKER_H_
 #define _AT_ALLOC_TRACKER_H_
 
+#ifdef AT_ALLOC_TRACK
+#include <string.h>
+#include "alloctracker_intern.h"
+#endif
+
 #ifdef __cplusplus
-extern C
+extern "C"
 {
 #endif
 
 #ifdef AT_ALLOC_TRACK
 
-#include <string.h>
-#include "alloctracker_intern.h"
-
 #define AT_FILENAME (strrchr(__FILE__, '/') ? strrchr(__FILE__, '/') + 1 : __FILE__)
 
-#if defined __STDC_VERSION__ && __STDC_VERSION__ >= 199901L
+#if defined __STDC_VERSION__ && __STDC_VERSION__ >= 199901L \
+ || defined __cplusplus && __cplusplus >= 201103L
 #define AT_FUNCTION __func__
 #else
 #define AT_FUNCTION ""
@@ -59,6 +62,74 @@ extern C
 #define getdelim(L, S, D, F) at_getdelim((L), (S), (D), (F), (AT_FILENAME), AT_FUNCTION, __LINE__)
 #endif
 
+#if defined __USE_XOPEN2K8 || __GLIBC_USE(LIB_EXT2) \
+ || defined _POSIX_C_SOURCE && _POSIX_C_SOURCE >= 200809L \
+ || defined _XOPEN_SOURCE && _XOPEN_SOURCE >= 700 \
+ || defined _GNU_SOURCE
+#undef strndup
+#define strndup(S, N) at_strndup((S), (N), (AT_FILENAME), AT_FUNCTION, __LINE__)
+#endif
+
+#if defined __USE_XOPEN2K \
+ || defined _POSIX_C_SOURCE && _POSIX_C_SOURCE >= 200112L
+#undef mmap
+#define mmap(A, L, P, F, D, O) at_mmap((A), (L), (P), (F), (D), (O), (AT_FILENAME), AT_FUNCTION, __LINE__)
+#undef munmap
+#define munmap(A, L) at_munmap((A), (L))
+#undef posix_memalign
+#define posix_memalign(P, A, S) at_posix_memalign((P), (A), (S), (AT_FILENAME), AT_FUNCTION, __LINE__)
+#endif
+
+#if defined __STDC_VERSION__ && __STDC_VERSION__ >= 199901L \
+ && defined _GNU_SOURCE
+#undef mremap
+#define mremap(...) at_mremap((AT_FILENAME), AT_FUNCTION, __LINE__, __VA_ARGS__)
+#undef asprintf
+#define asprintf(...) at_asprintf((AT_FILENAME), AT_FUNCTION, __LINE__, __VA_ARGS__)
+#endif
+
+#if defined __USE_ISOC11 \
+ || defined __STDC_VERSION__ && __STDC_VERSION__ >= 201112L
+#undef aligned_alloc
+#define aligned_alloc(A, S) at_aligned_alloc((A), (S), (AT_FILENAME), AT_FUNCTION, __LINE__)
+#endif
+
+#if defined __USE_MISC || defined _GNU_SOURCE
+#undef memalign
+#define memalign(A, S) at_memalign((A), (S), (AT_FILENAME), AT_FUNCTION, __LINE__)
+#undef reallocarray
+#define reallocarray(P, N, S) at_reallocarray((P), (N), (S), (AT_FILENAME), AT_FUNCTION, __LINE__)
+#endif
+
+#if defined __USE_XOPEN2K \
+ || defined _POSIX_C_SOURCE && _POSIX_C_SOURCE >= 200112L
+#if defined __STDC_VERSION__ && __STDC_VERSION__ >= 199901L
+#undef open
+#define open(...) at_open((AT_FILENAME), AT_FUNCTION, __LINE__, __VA_ARGS__)
+#endif
+#undef socket
+#define socket(D, T, P) at_socket((D), (T), (P), (AT_FILENAME), AT_FUNCTION, __LINE__)
+#undef accept
+#define accept(S, A, L) at_accept((S), (A), (L), (AT_FILENAME), AT_FUNCTION, __LINE__)
+#undef pipe
+#define pipe(D) at_pipe((D), (AT_FILENAME), AT_FUNCTION, __LINE__)
+#undef dup
+#define dup(D) at_dup((D), (AT_FILENAME), AT_FUNCTION, __LINE__)
+#undef dup2
+#define dup2(D, N) at_dup2((D), (N), (AT_FILENAME), AT_FUNCTION, __LINE__)
+#undef close
+#define close(D) at_close((D))
+#endif
+
+#ifdef __linux__
+#undef eventfd
+#define eventfd(I, F) at_eventfd((I), (F), (AT_FILENAME), AT_FUNCTION, __LINE__)
+#undef epoll_create
+#define epoll_create(S) at_epoll_create((S), (AT_FILENAME), AT_FUNCTION, __LINE__)
+#undef epoll_create1
+#define epoll_create1(F) at_epoll_create1((F), (AT_FILENAME), AT_FUNCTION, __LINE__)
+#endif
+
 #undef fopen
 #define fopen(N, M) at_fopen((N), (M), (AT_FILENAME), AT_FUNCTION, __LINE__)
 #undef freopen
@@ -68,20 +139,117 @@ extern C
 #undef fclose
 #define fclose(F) at_fclose((F))
 
+#ifdef AT_IO_TRACK
+#undef fread
+#define fread(P, S, N, F) at_fread((P), (S), (N), (F))
+#undef fwrite
+#define fwrite(P, S, N, F) at_fwrite((P), (S), (N), (F))
+#undef fgets
+#define fgets(S, N, F) at_fgets((S), (N), (F))
+#undef fputs
+#define fputs(S, F) at_fputs((S), (F))
+#undef setvbuf
+#define setvbuf(F, B, M, S) at_setvbuf((F), (B), (M), (S))
+#if defined __STDC_VERSION__ && __STDC_VERSION__ >= 199901L
+#undef fprintf
+#define fprintf(...) at_fprintf(__VA_ARGS__)
+#endif
+#endif
+
 #define AT_REPORT at_report()
 #define AT_FREE_ALL at_free_all()
+#define AT_SHUTDOWN(R) at_shutdown((R))
+#define AT_SHM_PUBLISH(N) at_shm_publish((N))
+#define AT_SAMPLER_START(P, I, N) at_sampler_start((P), (I), (N))
+#define AT_SAMPLER_STOP at_sampler_stop()
+#define AT_SCOPE_PUSH(T) at_scope_push((T))
+#define AT_SCOPE_POP at_scope_pop()
+#define AT_SCOPE_QUERY(T, S) at_scope_query((T), (S))
+#define AT_STATS_QUERY(S) at_stats_query((S))
+#define AT_SITE_QUERY(F, L, S) at_site_query((F), (L), (S))
+#define AT_FD_QUERY(D) at_fd_query((D))
+#define AT_STREAM_QUERY(F, S) at_stream_query((F), (S))
+#define AT_BUDGET(P, S, H) at_budget_set((P), (S), (H))
+#define AT_BUDGET_CALLBACK(F, D) at_budget_callback((F), (D))
+#define AT_LEAK_SCAN_START(I) at_leak_scan_start((I))
+#define AT_LEAK_SCAN_STOP at_leak_scan_stop()
+#define AT_LEAK_SUSPECTS(S, N) at_leak_suspects((S), (N))
+#define AT_LEAK_PASS at_leak_pass()
+#define AT_DUMP_ON_SIGNAL(S) at_dump_on_signal((S))
+#define AT_DUMP_STOP at_dump_stop()
+#define AT_REACH_SCAN at_reach_scan()
+#define AT_DUPLICATES(N) at_dup_enable((N))
+#define AT_DUP_SCAN at_dup_scan()
+#define AT_UNUSED(N) at_unused_enable((N))
+#define AT_UNUSED_SCAN at_unused_scan()
+#define AT_RECOMMEND(P) at_recommend((P))
+#define AT_COMPACT(E) at_compact_enable((E))
+#define AT_FAULT_START(P, I) at_fault_start((P), (I))
+#define AT_FAULT_STOP at_fault_stop()
 
 #else
 
 #define AT_REPORT
 #define AT_FREE_ALL
+#define AT_SHUTDOWN(R)
+#define AT_SHM_PUBLISH(N)
+#define AT_SAMPLER_START(P, I, N)
+#define AT_SAMPLER_STOP
+#define AT_SCOPE_PUSH(T)
+#define AT_SCOPE_POP
+#define AT_SCOPE_QUERY(T, S) (-1)
+#define AT_STATS_QUERY(S) (-1)
+#define AT_SITE_QUERY(F, L, S) (-1)
+#define AT_FD_QUERY(D) (-1)
+#define AT_STREAM_QUERY(F, S) (-1)
+#define AT_BUDGET(P, S, H)
+#define AT_BUDGET_CALLBACK(F, D)
+#define AT_LEAK_SCAN_START(I)
+#define AT_LEAK_SCAN_STOP
+#define AT_LEAK_SUSPECTS(S, N) (-1)
+#define AT_LEAK_PASS (-1)
+#define AT_DUMP_ON_SIGNAL(S)
+#define AT_DUMP_STOP
+#define AT_REACH_SCAN (-1)
+#define AT_DUPLICATES(N)
+#define AT_DUP_SCAN (-1)
+#define AT_UNUSED(N)
+#define AT_UNUSED_SCAN (-1)
+#define AT_RECOMMEND(P) (-1)
+#define AT_COMPACT(E)
+#define AT_FAULT_START(P, I) (-1)
+#define AT_FAULT_STOP
 
 #endif
 
 char *at_version(void);
 
+struct at_arena;
+struct at_arena *at_arena_create(const char *, size_t);
+void *at_arena_alloc(struct at_arena *, size_t);
+void at_arena_reset(struct at_arena *);
+void at_arena_destroy(struct at_arena *);
+
 #ifdef __cplusplus
 }
 #endif
 
+/* opt-in: capture the call site of "new" expressions, which breaks
+   placement "new" in the including source file */
+#if defined __cplusplus && defined AT_ALLOC_TRACK && defined AT_NEW_TRACK
+#include <cstddef>
+#include <new>
+void *operator new(std::size_t, const char *, const char *, int);
+void *operator new[](std::size_t, const char *, const char *, int);
+void operator delete(void *, const char *, const char *, int) noexcept;
+void operator delete[](void *, const char *, const char *, int) noexcept;
+#ifdef __cpp_aligned_new
+void *operator new(std::size_t, std::align_val_t, const char *, const char *, int);
+void *operator new[](std::size_t, std::align_val_t, const char *, const char *, int);
+void operator delete(void *, std::align_val_t, const char *, const char *, int) noexcept;
+void operator delete[](void *, std::align_val_t, const char *, const char *, int) noexcept;
+#endif
+#define new new((AT_FILENAME), AT_FUNCTION, __LINE__)
+#endif
+
 #endif
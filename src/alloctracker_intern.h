@@ -19,14 +19,15 @@
 #define ALLOC_TRACER_VERSION "0.5.3"
 #endif
 
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
 #ifdef __cplusplus
-extern C
+extern "C"
 {
 #endif
 
-#include <stdio.h>
-#include <stdlib.h>
-
 #define at_free_null(p) if(p) { free(p); p = NULL; }
 
 typedef struct at_track_stats
@@ -37,12 +38,15 @@ typedef struct at_track_stats
 	size_t free_no;
 	size_t open_no;
 	size_t close_no;
+	size_t mismatch_no;
+	size_t untracked_no;
 } at_track_stats_t;
 
 typedef enum at_list_type
 {
 	AT_LIST_TYPE_HEAP,
-	AT_LIST_TYPE_FILE
+	AT_LIST_TYPE_FILE,
+	AT_LIST_TYPE_MAP
 } at_list_type_t;
 
 typedef struct at_list_item
@@ -55,6 +59,208 @@ typedef struct at_list_item
 	int line;
 } at_list_item_t;
 
+#ifndef AT_SITE_THREAD_PAIRS
+#define AT_SITE_THREAD_PAIRS 4
+#endif
+
+typedef struct at_thread_pair
+{
+	size_t producer;
+	size_t consumer;
+	size_t count;
+} at_thread_pair_t;
+
+typedef struct at_site
+{
+	size_t id;
+	struct at_site *next;
+	char *filename;
+	char *function;
+	int line;
+	size_t alloc_no;
+	size_t alloc_amount;
+	size_t free_no;
+	size_t live_no;
+	size_t live_amount;
+	size_t peak_amount;
+	size_t realloc_no;
+	size_t realloc_chains;
+	size_t realloc_moves;
+	size_t realloc_copied;
+	size_t realloc_grown;
+	size_t realloc_linear;
+	double realloc_growth;
+	size_t remote_free_no;
+	size_t remote_realloc_no;
+	at_thread_pair_t pairs[AT_SITE_THREAD_PAIRS];
+	size_t pairs_other;
+	size_t shared_no;
+	size_t shared_threads[2];
+	struct at_site *shared_site;
+	size_t reuse_no;
+	struct at_site *reuse_site;
+	size_t sample_amount;
+	size_t budget_limit;
+	size_t budget_rearm;
+	size_t budget_soft;
+	size_t budget_hard;
+	long budget_logged;
+	size_t leak_live;
+	size_t leak_low;
+	size_t leak_streak;
+	size_t leak_pending;
+	uint64_t leak_pending_age;
+	size_t leak_old_no;
+	uint64_t leak_oldest;
+	unsigned int leak_score;
+	size_t reach_no;
+	size_t reach_amount;
+	size_t dup_no;
+	size_t dup_amount;
+	size_t peak_no;
+	size_t size_major;
+	size_t size_votes;
+	size_t size_hits;
+	uint64_t lifetime_sum;
+	size_t lifetime_no;
+	size_t fault_minor;
+	size_t fault_major;
+	size_t fault_touched;
+	size_t fault_resident;
+	size_t fault_probed;
+	size_t unused_no;
+	size_t unused_reserved;
+	size_t unused_used;
+} at_site_t;
+
+typedef void (*at_budget_callback_t)(const char *, const char *, int,
+	size_t, size_t, int, void *);
+
+typedef struct at_budget
+{
+	char *pattern;
+	size_t soft;
+	size_t hard;
+} at_budget_t;
+
+typedef struct at_line_owner
+{
+	size_t line;
+	size_t thread;
+	at_site_t *site;
+} at_line_owner_t;
+
+typedef struct at_site_table
+{
+	size_t capacity;
+	size_t length;
+	at_site_t **buckets;
+	at_site_t **sites;
+} at_site_table_t;
+
+typedef struct at_scope
+{
+	size_t id;
+	struct at_scope *next;
+	char *tag;
+	size_t alloc_no;
+	size_t alloc_amount;
+	size_t free_no;
+	size_t live_no;
+	size_t live_amount;
+	size_t peak_amount;
+} at_scope_t;
+
+typedef struct at_scope_table
+{
+	size_t capacity;
+	size_t length;
+	at_scope_t **buckets;
+	at_scope_t **scopes;
+} at_scope_table_t;
+
+typedef struct at_scope_stats
+{
+	size_t alloc_amount;
+	size_t alloc_no;
+	size_t free_no;
+	size_t live_amount;
+	size_t peak_amount;
+} at_scope_stats_t;
+
+typedef struct at_stats
+{
+	size_t alloc_no;
+	size_t free_no;
+	size_t live_no;
+	size_t live_amount;
+	size_t map_no;
+	size_t map_amount;
+	size_t fd_no;
+	size_t fd_open_no;
+	size_t fd_close_no;
+	size_t mismatch_no;
+	size_t untracked_no;
+	size_t meta_alloc_no;
+	size_t meta_held_amount;
+	size_t timed_alloc_no;
+	size_t timed_free_no;
+	size_t compact_no;
+	size_t squeeze_no;
+} at_stats_t;
+
+typedef struct at_site_stats
+{
+	size_t alloc_no;
+	size_t free_no;
+	size_t live_no;
+	size_t live_amount;
+	size_t realloc_no;
+	size_t remote_free_no;
+	size_t remote_realloc_no;
+	size_t reach_no;
+	size_t reach_amount;
+	size_t dup_no;
+	size_t dup_amount;
+	size_t fault_minor;
+	size_t fault_major;
+	size_t fault_touched;
+	size_t unused_no;
+	size_t unused_reserved;
+	size_t unused_used;
+} at_site_stats_t;
+
+#ifndef AT_LEAK_SLICE
+#define AT_LEAK_SLICE 4096
+#endif
+
+#ifndef AT_LEAK_SLICE_GAP
+#define AT_LEAK_SLICE_GAP 10
+#endif
+
+#define AT_LEAK_STREAK 8
+
+/* the names point into the tracker and stay valid until "at_free_all" */
+typedef struct at_leak_suspect
+{
+	const char *filename;
+	const char *function;
+	int line;
+	unsigned int score;
+	size_t live_no;
+	size_t live_amount;
+	size_t old_no;
+	uint64_t oldest;
+	size_t streak;
+} at_leak_suspect_t;
+
+typedef enum at_alloc_kind
+{
+	AT_ALLOC_KIND_MALLOC,
+	AT_ALLOC_KIND_NEW,
+	AT_ALLOC_KIND_NEW_ARRAY
+} at_alloc_kind_t;
+
 typedef struct at_heap_list_item
 {
 	size_t id;
@@ -65,8 +271,26 @@ typedef struct at_heap_list_item
 	int line;
 	void *pointer;
 	long size;
+	size_t alignment;
+	at_site_t *site;
+	at_scope_t *scope;
+	size_t thread;
+	size_t reallocs;
+	size_t increment;
+	at_alloc_kind_t kind;
+	uint64_t birth;
+	size_t touched;
+	char zeroed;
 } at_heap_list_item_t;
 
+typedef struct at_caller
+{
+	void *address;
+	char *filename;
+	char *function;
+	int line;
+} at_caller_t;
+
 typedef struct at_file_list_item
 {
 	size_t id;
@@ -78,14 +302,380 @@ typedef struct at_file_list_item
 	FILE *handle;
 	char *name;
 	char *mode;
+	size_t read_amount;
+	size_t read_no;
+	size_t write_amount;
+	size_t write_no;
+	int buffer_mode;
+	size_t buffer_size;
 } at_file_list_item_t;
 
+typedef struct at_stream_stats
+{
+	size_t read_amount;
+	size_t read_no;
+	size_t write_amount;
+	size_t write_no;
+} at_stream_stats_t;
+
+typedef struct at_map_list_item
+{
+	size_t id;
+	struct at_map_list_item *prev;
+	struct at_map_list_item *next;
+	char *filename;
+	char *function;
+	int line;
+	void *pointer;
+	size_t size;
+	int prot;
+	int flags;
+	int fd;
+	size_t pagesize;
+} at_map_list_item_t;
+
+typedef struct at_map_stats
+{
+	size_t map_amount;
+	size_t map_no;
+	size_t unmap_amount;
+	size_t unmap_no;
+	size_t peak_amount;
+	size_t huge_amount;
+} at_map_stats_t;
+
+typedef enum at_fd_type
+{
+	AT_FD_TYPE_FILE,
+	AT_FD_TYPE_SOCKET,
+	AT_FD_TYPE_PIPE,
+	AT_FD_TYPE_DUP,
+	AT_FD_TYPE_EVENT,
+	AT_FD_TYPE_EPOLL
+} at_fd_type_t;
+
+typedef struct at_fd_item
+{
+	size_t id;
+	char *filename;
+	char *function;
+	int line;
+	at_fd_type_t type;
+	char open;
+} at_fd_item_t;
+
+typedef struct at_fd_table
+{
+	size_t capacity;
+	size_t length;
+	at_fd_item_t *items;
+} at_fd_table_t;
+
+typedef struct at_fd_stats
+{
+	size_t open_no;
+	size_t close_no;
+	size_t peak_no;
+} at_fd_stats_t;
+
+typedef struct at_meta_timer
+{
+	uint64_t call_no;
+	uint64_t time;
+} at_meta_timer_t;
+
+typedef struct at_meta_stats
+{
+	size_t alloc_no;
+	size_t free_no;
+	size_t held_amount;
+	size_t peak_amount;
+	at_meta_timer_t alloc;
+	at_meta_timer_t free;
+	at_meta_timer_t lookup;
+	at_meta_timer_t report;
+} at_meta_stats_t;
+
+#ifndef AT_SHM_SLOTS
+#define AT_SHM_SLOTS 64
+#endif
+
+#define AT_SHM_MAGIC ((size_t)0x61747368)
+#define AT_SHM_TOP_SITES 4
+#define AT_SHM_SITE_NAME 48
+
+typedef struct at_shm_site
+{
+	char name[AT_SHM_SITE_NAME];
+	size_t live_amount;
+	size_t live_no;
+} at_shm_site_t;
+
+/* one slot per process, written under a sequence lock: the sequence
+   is odd while the owner updates the slot */
+typedef struct at_shm_slot
+{
+	size_t sequence;
+	int pid;
+	at_track_stats_t stats;
+	size_t live_amount;
+	size_t peak_amount;
+	at_shm_site_t sites[AT_SHM_TOP_SITES];
+} at_shm_slot_t;
+
+typedef struct at_shm_segment
+{
+	size_t magic;
+	size_t slot_no;
+	at_shm_slot_t slots[AT_SHM_SLOTS];
+} at_shm_segment_t;
+
+#define AT_SAMPLE_MAGIC ((uint64_t)0x617473616d706c65)
+#define AT_SAMPLE_TOP_SITES 4
+
+/* the ring file written by the sampler is a header followed by
+   "capacity" samples, sample "n" is stored at index "n % capacity";
+   all fields have a fixed width, so the file can be read by any tool */
+typedef struct at_sample_site
+{
+	char name[AT_SHM_SITE_NAME];
+	int64_t growth;
+	uint64_t live_amount;
+} at_sample_site_t;
+
+typedef struct at_sample
+{
+	uint64_t time;
+	uint64_t alloc_amount;
+	uint64_t alloc_no;
+	uint64_t free_amount;
+	uint64_t free_no;
+	uint64_t live_amount;
+	uint64_t live_no;
+	uint64_t file_no;
+	uint64_t fd_no;
+	at_sample_site_t sites[AT_SAMPLE_TOP_SITES];
+} at_sample_t;
+
+typedef struct at_sample_ring
+{
+	uint64_t magic;
+	uint64_t sample_size;
+	uint64_t capacity;
+	uint64_t interval;
+	uint64_t written;
+} at_sample_ring_t;
+
+#define AT_ARENA_ALIGNMENT 16
+
+typedef struct at_arena_chunk
+{
+	struct at_arena_chunk *next;
+	size_t size;
+	size_t used;
+} at_arena_chunk_t;
+
+typedef struct at_arena
+{
+	size_t id;
+	struct at_arena *prev;
+	struct at_arena *next;
+	char *name;
+	at_arena_chunk_t *first;
+	at_arena_chunk_t *current;
+	at_arena_chunk_t *last;
+	size_t capacity;
+	size_t used;
+	size_t peak;
+	size_t reserved;
+	size_t alloc_no;
+	size_t reset_no;
+	char destroyed;
+} at_arena_t;
+
+#ifndef AT_META_CHUNK
+#define AT_META_CHUNK 65536
+#endif
+
+/* list items and their strings are carved out of chunks, which are
+   released all at once when the tracker is torn down */
+typedef struct at_meta_chunk
+{
+	struct at_meta_chunk *next;
+	size_t used;
+} at_meta_chunk_t;
+
+typedef struct at_meta_pool
+{
+	at_meta_chunk_t *chunks;
+	struct at_list_item *recycled;
+} at_meta_pool_t;
+
+typedef struct at_meta_strings
+{
+	size_t capacity;
+	size_t length;
+	char **slots;
+	at_meta_chunk_t *chunks;
+} at_meta_strings_t;
+
+#ifndef AT_REACH_THREADS
+#define AT_REACH_THREADS 8
+#endif
+
+#ifndef AT_REACH_TASKS
+#define AT_REACH_TASKS 1024
+#endif
+
+#define AT_REACH_CHUNK 65536
+#define AT_REACH_LOCAL 4096
+#define AT_REACH_BATCH 64
+
+typedef struct at_reach_range
+{
+	uintptr_t start;
+	uintptr_t end;
+} at_reach_range_t;
+
+typedef struct at_reach_block
+{
+	uintptr_t start;
+	uintptr_t end;
+	at_site_t *site;
+} at_reach_block_t;
+
+/* the state of a reachability scan lives in an anonymous mapping, so that
+   the addresses it holds are not taken for roots themselves */
+typedef struct at_reach
+{
+	at_reach_block_t *blocks;
+	unsigned char *marks;
+	size_t length;
+	uintptr_t low;
+	uintptr_t high;
+	at_reach_range_t *roots;
+	size_t root_no;
+	size_t root_capacity;
+	size_t root_dropped;
+	at_reach_range_t *maps;
+	size_t map_no;
+	size_t map_capacity;
+	at_reach_range_t *queue;
+	size_t queue_length;
+	size_t queue_capacity;
+	size_t workers;
+	size_t idle;
+	char done;
+	int worker_tids[AT_REACH_THREADS];
+	int tasks[AT_REACH_TASKS];
+	size_t task_no;
+	size_t task_dropped;
+} at_reach_t;
+
+#ifndef AT_CLASS_LIMIT
+#define AT_CLASS_LIMIT 4096
+#endif
+
+#ifndef AT_CLASS_COUNT
+#define AT_CLASS_COUNT 8
+#endif
+
+#ifndef AT_CLASS_COVERAGE
+#define AT_CLASS_COVERAGE 95
+#endif
+
+#ifndef AT_POOL_MIN_ALLOCS
+#define AT_POOL_MIN_ALLOCS 64
+#endif
+
+#ifndef AT_POOL_HIT_RATE
+#define AT_POOL_HIT_RATE 90
+#endif
+
+#define AT_CLASS_GRANULE 8
+#define AT_CLASS_GRANULES ((AT_CLASS_LIMIT / AT_CLASS_GRANULE) + 1)
+
+#ifndef AT_COMPACT_MIN
+#define AT_COMPACT_MIN 4096
+#endif
+
+/* a block tracked in compact mode takes 16 bytes: the id of its site, the
+   address in the low 48 bits of "word", and the size split into the high
+   16 bits of "word" and "size_low"; an address of 0 marks a freed record */
+typedef struct at_compact_record
+{
+	uint32_t site;
+	uint32_t size_low;
+	uint64_t word;
+} at_compact_record_t;
+
+/* the records are kept in allocation order, freed ones are squeezed out
+   once they outnumber the live ones; "slots" index the live records by
+   address, holding their position plus one */
+typedef struct at_compact
+{
+	at_compact_record_t *records;
+	size_t length;
+	size_t capacity;
+	size_t live;
+	uint32_t *slots;
+	size_t slot_capacity;
+	size_t squeeze_no;
+} at_compact_t;
+
+#ifndef AT_FAULT_EVENTS
+#define AT_FAULT_EVENTS 128
+#endif
+
+/* the ring of each event, a power of two */
+#ifndef AT_FAULT_PAGES
+#define AT_FAULT_PAGES 8
+#endif
+
+/* smaller blocks share their pages with others */
+#ifndef AT_FAULT_MIN_BLOCK
+#define AT_FAULT_MIN_BLOCK 4096
+#endif
+
+/* blocks of at least the mmap threshold of glibc, starting right after
+   the chunk header at the head of a page, are mapped on their own */
+#ifndef AT_UNUSED_MIN_MAP
+#define AT_UNUSED_MIN_MAP ((size_t)128 << 10)
+#endif
+
+#define AT_UNUSED_HEAD 64
+
+#define AT_FAULT_SAMPLES 4096
+
+/* a page fault event of one thread and its ring buffer */
+typedef struct at_fault_event
+{
+	int fd;
+	char major;
+	void *ring;
+} at_fault_event_t;
+
+typedef struct at_dup_entry
+{
+	uint64_t hash;
+	at_heap_list_item_t *item;
+	char copy;
+} at_dup_entry_t;
+
+typedef struct at_index
+{
+	size_t capacity;
+	size_t length;
+	struct at_list_item **slots;
+} at_index_t;
+
 typedef struct at_list
 {
 	size_t length;
 	struct at_list_item *first;
 	struct at_list_item *last;
 	at_list_type_t type;
+	at_index_t *index;
 } at_list_t;
 
 char *at_truncate_back(const char *, int);
@@ -97,18 +687,49 @@ char *at_truncate_front(const char *, int);
 #define at_truncate(S, L) at_truncate_front((S), (L))
 #endif
 
+at_site_t *at_site_get(const char *, const char *, int);
+
 at_heap_list_item_t *at_heap_list_item_new(const char *, const char *, int);
 at_file_list_item_t *at_file_list_item_new(const char *, const char *, int);
+at_map_list_item_t *at_map_list_item_new(const char *, const char *, int);
 
 void at_list_add(at_list_t *, at_list_item_t *, at_list_type_t);
 void at_list_remove(at_list_t *, void *);
 at_list_item_t *at_list_get(at_list_t *, void *);
+void at_list_rekey(at_list_t *, at_list_item_t *, void *);
 void at_list_free_item(at_list_item_t **, at_list_type_t);
-void at_list_free(at_list_t *);
+void at_list_free(at_list_t *, char);
 size_t at_list_length(at_list_t *);
 
 void at_free_all(void);
+void at_shutdown(int);
 void at_report(void);
+int at_shm_publish(const char *);
+int at_sampler_start(const char *, unsigned int, size_t);
+void at_sampler_stop(void);
+void at_scope_push(const char *);
+void at_scope_pop(void);
+int at_scope_query(const char *, at_scope_stats_t *);
+int at_stats_query(at_stats_t *);
+int at_site_query(const char *, int, at_site_stats_t *);
+int at_fd_query(int);
+int at_leak_scan_start(unsigned int);
+void at_leak_scan_stop(void);
+int at_leak_suspects(at_leak_suspect_t *, size_t);
+int at_leak_pass(void);
+int at_dump_on_signal(int);
+void at_dump_stop(void);
+int at_reach_scan(void);
+void at_dup_enable(size_t);
+int at_dup_scan(void);
+void at_unused_enable(size_t);
+int at_unused_scan(void);
+int at_recommend(const char *);
+void at_compact_enable(int);
+int at_fault_start(unsigned int, unsigned int);
+void at_fault_stop(void);
+int at_budget_set(const char *, size_t, size_t);
+void at_budget_callback(at_budget_callback_t, void *);
 
 void *at_malloc(size_t, const char *, const char *, int);
 void *at_calloc(size_t, size_t, const char *, const char *, int);
@@ -130,16 +751,65 @@ char *strdup(const char *);
  || defined _GNU_SOURCE
 size_t at_getline(char **, size_t *, FILE *, const char *, const char *, int);
 size_t at_getdelim(char **, size_t *, int, FILE *, const char *, const char *, int);
+char *at_strndup(const char *, size_t, const char *, const char *, int);
 #endif
 
+#if defined __USE_XOPEN2K \
+ || defined _POSIX_C_SOURCE && _POSIX_C_SOURCE >= 200112L
+#include <sys/types.h>
+void *at_mmap(void *, size_t, int, int, int, off_t, const char *, const char *, int);
+int at_munmap(void *, size_t);
+int at_posix_memalign(void **, size_t, size_t, const char *, const char *, int);
+#endif
+
+#if defined __USE_XOPEN2K \
+ || defined _POSIX_C_SOURCE && _POSIX_C_SOURCE >= 200112L
+#include <sys/socket.h>
+int at_socket(int, int, int, const char *, const char *, int);
+int at_accept(int, struct sockaddr *, socklen_t *, const char *, const char *, int);
+int at_pipe(int *, const char *, const char *, int);
+int at_dup(int, const char *, const char *, int);
+int at_dup2(int, int, const char *, const char *, int);
+int at_close(int);
+#if defined __STDC_VERSION__ && __STDC_VERSION__ >= 199901L
+int at_open(const char *, const char *, int, const char *, int, ...);
+#endif
+#endif
+
+#ifdef __linux__
+int at_eventfd(unsigned int, int, const char *, const char *, int);
+int at_epoll_create(int, const char *, const char *, int);
+int at_epoll_create1(int, const char *, const char *, int);
+#endif
+
+#if defined __STDC_VERSION__ && __STDC_VERSION__ >= 199901L
+void *at_mremap(const char *, const char *, int, void *, size_t, size_t, int, ...);
+int at_asprintf(const char *, const char *, int, char **, const char *, ...);
+#endif
+
+void *at_aligned_alloc(size_t, size_t, const char *, const char *, int);
+void *at_memalign(size_t, size_t, const char *, const char *, int);
+void *at_reallocarray(void *, size_t, size_t, const char *, const char *, int);
+
 void at_free(void *);
 
+void *at_new(size_t, size_t, at_alloc_kind_t, void *, const char *, const char *, int);
+void at_delete(void *, size_t, size_t, at_alloc_kind_t);
+
 FILE *at_fopen(const char *, const char *, const char *, const char *, int);
 FILE *at_freopen(char *, const char *, FILE *, const char *, const char *, int);
 FILE *at_tmpfile(const char *, const char *, int);
 
 void at_fclose(FILE *);
 
+int at_stream_query(FILE *, at_stream_stats_t *);
+size_t at_fread(void *, size_t, size_t, FILE *);
+size_t at_fwrite(const void *, size_t, size_t, FILE *);
+char *at_fgets(char *, int, FILE *);
+int at_fputs(const char *, FILE *);
+int at_fprintf(FILE *, const char *, ...);
+int at_setvbuf(FILE *, char *, int, size_t);
+
 #ifdef __cplusplus
 }
 #endif
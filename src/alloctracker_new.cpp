@@ -0,0 +1,196 @@
+/**
+ * alloctracker - track dynamic memory allocations and open files
+ * Copyright (C) 2019-2020 Daniel Haase
+ * Distributed under the Boost Software License, Version 1.0.
+ * See accompanying file LICENSE or copy at
+ * https://www.boost.org/LICENSE_1_0.txt
+ *
+ * The project is inspired by code written by my colleague Jan Z.
+ *
+ * File:    alloctracker_new.cpp
+ * Author:  Daniel Haase
+ *
+ * Replacements of the global "operator new" and "operator delete"
+ * which feed C++ allocations into the tracker.
+ *
+ */
+
+#include <cstddef>
+#include <new>
+#include "alloctracker_intern.h"
+
+#define AT_CALLER __builtin_return_address(0)
+
+static void *at_new_throwing(std::size_t length, std::size_t alignment, at_alloc_kind_t kind,
+	void *caller, const char *filename, const char *function, int line)
+{
+	void *pointer = NULL;
+	std::new_handler handler;
+
+	/* as required for "operator new", the new handler is called until
+	   the allocation succeeds */
+	while(!(pointer = at_new(length, alignment, kind, caller, filename, function, line)))
+	{
+		if(!(handler = std::get_new_handler())) throw std::bad_alloc();
+		handler();
+	}
+
+	return pointer;
+}
+
+static void *at_new_nothrow(std::size_t length, std::size_t alignment, at_alloc_kind_t kind,
+	void *caller) noexcept
+{
+	try { return at_new_throwing(length, alignment, kind, caller, NULL, NULL, 0); }
+	catch(...) { return NULL; }
+}
+
+void *operator new(std::size_t length)
+{
+	return at_new_throwing(length, 0, AT_ALLOC_KIND_NEW, AT_CALLER, NULL, NULL, 0);
+}
+
+void *operator new[](std::size_t length)
+{
+	return at_new_throwing(length, 0, AT_ALLOC_KIND_NEW_ARRAY, AT_CALLER, NULL, NULL, 0);
+}
+
+void *operator new(std::size_t length, const std::nothrow_t &) noexcept
+{
+	return at_new_nothrow(length, 0, AT_ALLOC_KIND_NEW, AT_CALLER);
+}
+
+void *operator new[](std::size_t length, const std::nothrow_t &) noexcept
+{
+	return at_new_nothrow(length, 0, AT_ALLOC_KIND_NEW_ARRAY, AT_CALLER);
+}
+
+void *operator new(std::size_t length, const char *filename, const char *function, int line)
+{
+	return at_new_throwing(length, 0, AT_ALLOC_KIND_NEW, AT_CALLER, filename, function, line);
+}
+
+void *operator new[](std::size_t length, const char *filename, const char *function, int line)
+{
+	return at_new_throwing(length, 0, AT_ALLOC_KIND_NEW_ARRAY, AT_CALLER, filename, function, line);
+}
+
+void operator delete(void *pointer) noexcept
+{
+	at_delete(pointer, 0, 0, AT_ALLOC_KIND_NEW);
+}
+
+void operator delete[](void *pointer) noexcept
+{
+	at_delete(pointer, 0, 0, AT_ALLOC_KIND_NEW_ARRAY);
+}
+
+void operator delete(void *pointer, const std::nothrow_t &) noexcept
+{
+	at_delete(pointer, 0, 0, AT_ALLOC_KIND_NEW);
+}
+
+void operator delete[](void *pointer, const std::nothrow_t &) noexcept
+{
+	at_delete(pointer, 0, 0, AT_ALLOC_KIND_NEW_ARRAY);
+}
+
+void operator delete(void *pointer, const char *, const char *, int) noexcept
+{
+	at_delete(pointer, 0, 0, AT_ALLOC_KIND_NEW);
+}
+
+void operator delete[](void *pointer, const char *, const char *, int) noexcept
+{
+	at_delete(pointer, 0, 0, AT_ALLOC_KIND_NEW_ARRAY);
+}
+
+#ifdef __cpp_sized_deallocation
+void operator delete(void *pointer, std::size_t length) noexcept
+{
+	at_delete(pointer, length, 0, AT_ALLOC_KIND_NEW);
+}
+
+void operator delete[](void *pointer, std::size_t length) noexcept
+{
+	at_delete(pointer, length, 0, AT_ALLOC_KIND_NEW_ARRAY);
+}
+#endif
+
+#ifdef __cpp_aligned_new
+void *operator new(std::size_t length, std::align_val_t alignment)
+{
+	return at_new_throwing(length, static_cast<std::size_t>(alignment),
+	                       AT_ALLOC_KIND_NEW, AT_CALLER, NULL, NULL, 0);
+}
+
+void *operator new[](std::size_t length, std::align_val_t alignment)
+{
+	return at_new_throwing(length, static_cast<std::size_t>(alignment),
+	                       AT_ALLOC_KIND_NEW_ARRAY, AT_CALLER, NULL, NULL, 0);
+}
+
+void *operator new(std::size_t length, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+	return at_new_nothrow(length, static_cast<std::size_t>(alignment), AT_ALLOC_KIND_NEW, AT_CALLER);
+}
+
+void *operator new[](std::size_t length, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+	return at_new_nothrow(length, static_cast<std::size_t>(alignment), AT_ALLOC_KIND_NEW_ARRAY, AT_CALLER);
+}
+
+void *operator new(std::size_t length, std::align_val_t alignment,
+	const char *filename, const char *function, int line)
+{
+	return at_new_throwing(length, static_cast<std::size_t>(alignment),
+	                       AT_ALLOC_KIND_NEW, AT_CALLER, filename, function, line);
+}
+
+void *operator new[](std::size_t length, std::align_val_t alignment,
+	const char *filename, const char *function, int line)
+{
+	return at_new_throwing(length, static_cast<std::size_t>(alignment),
+	                       AT_ALLOC_KIND_NEW_ARRAY, AT_CALLER, filename, function, line);
+}
+
+void operator delete(void *pointer, std::align_val_t alignment) noexcept
+{
+	at_delete(pointer, 0, static_cast<std::size_t>(alignment), AT_ALLOC_KIND_NEW);
+}
+
+void operator delete[](void *pointer, std::align_val_t alignment) noexcept
+{
+	at_delete(pointer, 0, static_cast<std::size_t>(alignment), AT_ALLOC_KIND_NEW_ARRAY);
+}
+
+void operator delete(void *pointer, std::size_t length, std::align_val_t alignment) noexcept
+{
+	at_delete(pointer, length, static_cast<std::size_t>(alignment), AT_ALLOC_KIND_NEW);
+}
+
+void operator delete[](void *pointer, std::size_t length, std::align_val_t alignment) noexcept
+{
+	at_delete(pointer, length, static_cast<std::size_t>(alignment), AT_ALLOC_KIND_NEW_ARRAY);
+}
+
+void operator delete(void *pointer, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+	at_delete(pointer, 0, static_cast<std::size_t>(alignment), AT_ALLOC_KIND_NEW);
+}
+
+void operator delete[](void *pointer, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+	at_delete(pointer, 0, static_cast<std::size_t>(alignment), AT_ALLOC_KIND_NEW_ARRAY);
+}
+
+void operator delete(void *pointer, std::align_val_t alignment, const char *, const char *, int) noexcept
+{
+	at_delete(pointer, 0, static_cast<std::size_t>(alignment), AT_ALLOC_KIND_NEW);
+}
+
+void operator delete[](void *pointer, std::align_val_t alignment, const char *, const char *, int) noexcept
+{
+	at_delete(pointer, 0, static_cast<std::size_t>(alignment), AT_ALLOC_KIND_NEW_ARRAY);
+}
+#endif
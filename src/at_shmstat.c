@@ -0,0 +1,184 @@
+/**
+ * alloctracker - track dynamic memory allocations and open files
+ * Copyright (C) 2019-2020 Daniel Haase
+ * Distributed under the Boost Software License, Version 1.0.
+ * See accompanying file LICENSE or copy at
+ * https://www.boost.org/LICENSE_1_0.txt
+ *
+ * The project is inspired by code written by my colleague Jan Z.
+ *
+ * File:    at_shmstat.c
+ * Author:  Daniel Haase
+ *
+ * Aggregate the statistics published by all processes attached
+ * to a shared memory segment (see "at_shm_publish").
+ *
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "alloctracker_intern.h"
+
+#define AT_SHMSTAT_TOP_SITES 8
+
+/* copy a slot consistently, retrying while its owner updates it */
+static void at_shm_read(const at_shm_slot_t *slot, at_shm_slot_t *copy)
+{
+	size_t sequence = 0;
+
+	for(;;)
+	{
+		sequence = __atomic_load_n(&(slot->sequence), __ATOMIC_ACQUIRE);
+
+		if(sequence & 1)
+		{
+			sched_yield();
+			continue;
+		}
+
+		memcpy(copy, slot, sizeof(at_shm_slot_t));
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if(__atomic_load_n(&(slot->sequence), __ATOMIC_RELAXED) == sequence) return;
+	}
+}
+
+static int at_shm_site_compare(const void *a, const void *b)
+{
+	const at_shm_site_t *x = (const at_shm_site_t *)a;
+	const at_shm_site_t *y = (const at_shm_site_t *)b;
+
+	if(x->live_amount > y->live_amount) return -1;
+	return (x->live_amount < y->live_amount);
+}
+
+static void at_shm_print(const at_shm_segment_t *segment)
+{
+	at_shm_slot_t slot;
+	at_shm_site_t sites[(AT_SHM_SLOTS * AT_SHM_TOP_SITES)];
+	at_track_stats_t total;
+	size_t i = 0, j = 0, k = 0, length = 0, processes = 0;
+	size_t live = 0, peak = 0;
+	char alive = (char)0;
+
+	memset(&total, '\0', sizeof(at_track_stats_t));
+	printf("%8s  %-6s  %12s  %12s  %10s  %10s  %6s  %6s\n", "pid", "state",
+	       "live", "peak", "allocs", "frees", "opens", "closes");
+
+	for(i = 0; (i < segment->slot_no) && (i < AT_SHM_SLOTS); i++)
+	{
+		at_shm_read(&(segment->slots[i]), &slot);
+		if(!(slot.pid)) continue;
+
+		++processes;
+		alive = (char)((kill(slot.pid, 0) == 0) || (errno != ESRCH));
+		printf("%8d  %-6s  %12lu  %12lu  %10lu  %10lu  %6lu  %6lu\n", slot.pid,
+		       (alive ? "alive" : "gone"), (unsigned long)(slot.live_amount),
+		       (unsigned long)(slot.peak_amount), (unsigned long)(slot.stats.alloc_no),
+		       (unsigned long)(slot.stats.free_no), (unsigned long)(slot.stats.open_no),
+		       (unsigned long)(slot.stats.close_no));
+
+		total.alloc_amount += slot.stats.alloc_amount;
+		total.alloc_no += slot.stats.alloc_no;
+		total.free_amount += slot.stats.free_amount;
+		total.free_no += slot.stats.free_no;
+		total.open_no += slot.stats.open_no;
+		total.close_no += slot.stats.close_no;
+		live += slot.live_amount;
+		peak += slot.peak_amount;
+
+		/* sites of the same name are merged across processes */
+		for(j = 0; (j < AT_SHM_TOP_SITES) && slot.sites[j].name[0]; j++)
+		{
+			slot.sites[j].name[(AT_SHM_SITE_NAME - 1)] = '\0';
+
+			for(k = 0; k < length; k++)
+				if(!strcmp(sites[k].name, slot.sites[j].name)) break;
+
+			if(k == length) memcpy(&(sites[length++]), &(slot.sites[j]), sizeof(at_shm_site_t));
+			else
+			{
+				sites[k].live_amount += slot.sites[j].live_amount;
+				sites[k].live_no += slot.sites[j].live_no;
+			}
+		}
+	}
+
+	printf("%8lu  %-6s  %12lu  %12lu  %10lu  %10lu  %6lu  %6lu\n\n",
+	       (unsigned long)processes, "total", (unsigned long)live, (unsigned long)peak,
+	       (unsigned long)(total.alloc_no), (unsigned long)(total.free_no),
+	       (unsigned long)(total.open_no), (unsigned long)(total.close_no));
+
+	if(!length) return;
+
+	qsort(sites, length, sizeof(at_shm_site_t), at_shm_site_compare);
+	printf("top sites by live bytes:\n");
+
+	for(k = 0; (k < length) && (k < AT_SHMSTAT_TOP_SITES); k++)
+		printf("  %-40s  %12lu bytes in %lu blocks\n", sites[k].name,
+		       (unsigned long)(sites[k].live_amount), (unsigned long)(sites[k].live_no));
+
+	printf("\n");
+}
+
+int main(int argc, char **argv)
+{
+	at_shm_segment_t *segment = NULL;
+	struct stat info;
+	void *mapping = NULL;
+	unsigned int interval = 0;
+	int fd = -1;
+
+	if((argc < 2) || (argc > 3))
+	{
+		fprintf(stderr, "usage: %s <segment> [interval]\n", argv[0]);
+		return 1;
+	}
+
+	if(argc == 3) interval = (unsigned int)strtoul(argv[2], NULL, 10);
+
+	if(((fd = shm_open(argv[1], O_RDONLY, 0)) < 0) || (fstat(fd, &info) != 0) ||
+	   ((size_t)(info.st_size) != sizeof(at_shm_segment_t)))
+	{
+		fprintf(stderr, "%s: no compatible segment \"%s\"\n", argv[0], argv[1]);
+		if(fd >= 0) close(fd);
+		return 1;
+	}
+
+	mapping = mmap(NULL, sizeof(at_shm_segment_t), PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+
+	if(mapping == MAP_FAILED)
+	{
+		fprintf(stderr, "%s: failed to map segment \"%s\"\n", argv[0], argv[1]);
+		return 1;
+	}
+
+	segment = (at_shm_segment_t *)mapping;
+
+	if(__atomic_load_n(&(segment->magic), __ATOMIC_ACQUIRE) != AT_SHM_MAGIC)
+	{
+		fprintf(stderr, "%s: segment \"%s\" not initialized\n", argv[0], argv[1]);
+		munmap(mapping, sizeof(at_shm_segment_t));
+		return 1;
+	}
+
+	do
+	{
+		at_shm_print(segment);
+		if(interval) sleep(interval);
+	}
+	while(interval);
+
+	munmap(mapping, sizeof(at_shm_segment_t));
+	return 0;
+}
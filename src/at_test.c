@@ -12,15 +12,28 @@
  *
  */
 
+#define _GNU_SOURCE
+
 #include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
 #include "alloctracker.h"
 
 void exit_handler(void)
 {
 	remove("rsc/nosuchfilewithaverylongname.dat");
+	remove("rsc/samples.ring");
+	remove("rsc/recommend.json");
 	AT_REPORT;
 	AT_FREE_ALL;
 	printf("[ ok ] done\n\n");
@@ -57,9 +70,127 @@ static void test_realloc(void)
 {
 	char *memory1 = (char *)malloc(2048 * sizeof(char));
 	char *memory2 = (char *)malloc(2 * sizeof(char));
+	char *memory3 = (char *)malloc(64 * sizeof(char));
+#ifdef AT_ALLOC_TRACK
+	at_stats_t before, after;
+#endif
 
 	memory1 = (char *)realloc(memory1, 256);
 	memory2 = (char *)realloc(memory2, 128);
+
+#ifdef AT_ALLOC_TRACK
+	assert(AT_STATS_QUERY(&before) == 0);
+#endif
+
+	/* a failed resize keeps the block as it was */
+	assert(!realloc(memory3, ((size_t)1 << 62)));
+	memset(memory3, 'x', 64);
+
+#ifdef AT_ALLOC_TRACK
+	assert(AT_STATS_QUERY(&after) == 0);
+	assert((after.live_no == before.live_no) && (after.live_amount == before.live_amount));
+#endif
+
+	free(memory3);
+
+#ifdef AT_ALLOC_TRACK
+	assert(AT_STATS_QUERY(&after) == 0);
+	assert((after.live_no == (before.live_no - 1)) &&
+	       (after.live_amount == (before.live_amount - 64)));
+#endif
+}
+
+static void test_meta(void)
+{
+	char *blocks[4];
+	int i;
+#ifdef AT_ALLOC_TRACK
+	at_stats_t before, after;
+
+	assert(AT_STATS_QUERY(&before) == 0);
+#endif
+
+	/* every entry point is timed, once per call */
+	blocks[0] = (char *)malloc(16);
+	blocks[1] = (char *)calloc(2, 16);
+	blocks[0] = (char *)realloc(blocks[0], 64);
+	blocks[2] = strndup("metadata", 4);
+	blocks[3] = (char *)memalign(64, 16);
+	for(i = 0; i < 4; i++) free(blocks[i]);
+
+#ifdef AT_ALLOC_TRACK
+	assert(AT_STATS_QUERY(&after) == 0);
+	assert((after.timed_alloc_no == (before.timed_alloc_no + 5)) &&
+	       (after.timed_free_no == (before.timed_free_no + 4)));
+	assert(after.meta_alloc_no && after.meta_held_amount);
+#endif
+}
+
+static void *consumer(void *queue)
+{
+	char **blocks = (char **)queue;
+	int i;
+
+	for(i = 0; i < 8; i++) free(blocks[i]);
+	for(i = 0; i < 4; i++) blocks[i] = (char *)malloc(32); /* reuses lines */
+	return NULL;
+}
+
+static void *resizer(void *block)
+{
+	return realloc(block, 4096);
+}
+
+static void test_threads(void)
+{
+	char *queue[8], *neighbour = NULL, *resized = NULL;
+	pthread_t thread;
+	int i, queued = 0, sized = 0;
+#ifdef AT_ALLOC_TRACK
+	at_site_stats_t site;
+#endif
+
+	queued = (__LINE__ + 1);
+	for(i = 0; i < 8; i++) queue[i] = (char *)malloc(32);
+	neighbour = (char *)malloc(32); /* kept live next to the queue */
+	assert(neighbour);
+
+	assert(pthread_create(&thread, NULL, consumer, queue) == 0);
+	assert(pthread_join(thread, NULL) == 0);
+
+	sized = (__LINE__ + 1);
+	resized = (char *)malloc(64);
+	assert(pthread_create(&thread, NULL, resizer, resized) == 0);
+	assert(pthread_join(thread, (void **)&resized) == 0);
+	free(resized);
+
+#ifdef AT_ALLOC_TRACK
+	assert(AT_SITE_QUERY(__FILE__, queued, &site) == 0);
+	assert((site.free_no == 8) && (site.remote_free_no == 8) && !(site.remote_realloc_no));
+
+	/* the resize is charged to the site of the "realloc", not as a free */
+	assert(AT_SITE_QUERY(__FILE__, sized, &site) == 0);
+	assert(!(site.free_no) && !(site.remote_free_no) && (site.remote_realloc_no == 1));
+#else
+	(void)queued;
+	(void)sized;
+#endif
+}
+
+static void test_realloc_growth(void)
+{
+	char *buffer = NULL;
+	size_t length = 0;
+	int i;
+
+	for(i = 0; i < 32; i++)
+	{
+		length += 16; /* grows linearly, not geometrically */
+		buffer = (char *)realloc(buffer, length);
+		memset(&buffer[(length - 16)], 'x', 16);
+	}
+
+	free(buffer);
 }
 
 #if defined _XOPEN_SOURCE && _XOPEN_SOURCE >= 500 \
@@ -70,6 +201,33 @@ static void test_strdup(void)
 	char *alphabet = strdup("abcdefghijklmnopqrstuvwxyz");
 	assert(strlen(alphabet) == 26);
 }
+
+static void test_duplicates(void)
+{
+	at_site_stats_t site;
+	char *hosts[8], *ports[3];
+	int i, line = 0, other = 0;
+
+	AT_DUPLICATES(256);
+
+	/* 7 of the 8 copies are reported at exit as saved by interning */
+	line = (__LINE__ + 1);
+	for(i = 0; i < 8; i++) hosts[i] = strdup("backend.example.org");
+	assert(!strcmp(hosts[7], "backend.example.org"));
+
+	/* a copy of the second port only, not of the first */
+	other = (__LINE__ + 1);
+	for(i = 0; i < 3; i++) ports[i] = strdup((i ? "8443" : "8080"));
+	assert(!strcmp(ports[2], "8443"));
+
+#ifdef AT_ALLOC_TRACK
+	assert(AT_DUP_SCAN >= 8);
+	assert((AT_SITE_QUERY(__FILE__, line, &site) == 0) &&
+	       (site.dup_no == 7) && (site.dup_amount == 140));
+	assert((AT_SITE_QUERY(__FILE__, other, &site) == 0) &&
+	       (site.dup_no == 1) && (site.dup_amount == 5));
+#endif
+}
 #endif
 
 #if defined __USE_XOPEN2K8 || __GLIBC_USE(LIB_EXT2) \
@@ -101,9 +259,13 @@ static void test_getline(const char prealloc)
 
 	while(!feof(file))
 	{
+		errno = ERANGE;
+
 		if((len = (long)getline(&line, &blen, file)) == (-1L))
 			break; /* error or end of file condition */
 
+		assert(errno == ERANGE); /* left alone on success */
+
 		if(line)
 		{
 			if((len > (-1L)) && (line[(strlen(line) - 1)] == '\n'))
@@ -140,6 +302,632 @@ static void test_getline(const char prealloc)
 }
 #endif
 
+#if defined __USE_XOPEN2K \
+ || defined _POSIX_C_SOURCE && _POSIX_C_SOURCE >= 200112L
+static void test_mmap(void)
+{
+	size_t page = (size_t)sysconf(_SC_PAGESIZE);
+	char *region = NULL, *moved = NULL;
+	void *aligned = NULL;
+#ifdef AT_ALLOC_TRACK
+	at_stats_t before, after;
+
+	assert(AT_STATS_QUERY(&before) == 0);
+#endif
+
+	region = (char *)mmap(NULL, (4 * page), PROT_READ | PROT_WRITE,
+	                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	assert(region != MAP_FAILED);
+	assert(munmap(&region[page], page) == 0); /* splits the mapping */
+	assert(munmap(region, page) == 0);
+
+#ifdef AT_ALLOC_TRACK
+	assert(AT_STATS_QUERY(&after) == 0);
+	assert((after.map_no == (before.map_no + 1)) &&
+	       (after.map_amount == (before.map_amount + (2 * page))));
+#endif
+
+#if defined __STDC_VERSION__ && __STDC_VERSION__ >= 199901L \
+ && defined _GNU_SOURCE
+	moved = (char *)mremap(&region[(2 * page)], (2 * page), (3 * page), MREMAP_MAYMOVE);
+	assert(moved != MAP_FAILED);
+#ifdef AT_ALLOC_TRACK
+	assert(AT_STATS_QUERY(&after) == 0);
+	assert((after.map_no == (before.map_no + 1)) &&
+	       (after.map_amount == (before.map_amount + (3 * page))));
+#endif
+	assert(munmap(moved, (3 * page)) == 0);
+#else
+	assert(munmap(&region[(2 * page)], (2 * page)) == 0);
+	(void)moved;
+#endif
+
+	assert(posix_memalign(&aligned, 64, 100) == 0);
+	assert(((size_t)aligned % 64) == 0);
+
+#ifdef AT_ALLOC_TRACK
+	assert(AT_STATS_QUERY(&after) == 0);
+	assert((after.map_no == before.map_no) && (after.map_amount == before.map_amount));
+	assert((after.live_no == (before.live_no + 1)) &&
+	       (after.live_amount == (before.live_amount + 100)));
+#endif
+}
+
+static void test_aligned(void)
+{
+	char *block = NULL, *page = NULL, *array = NULL;
+#ifdef AT_ALLOC_TRACK
+	at_stats_t before, after;
+
+	assert(AT_STATS_QUERY(&before) == 0);
+#endif
+
+#if defined __USE_ISOC11 \
+ || defined __STDC_VERSION__ && __STDC_VERSION__ >= 201112L
+	block = (char *)aligned_alloc(64, 128);
+#else
+	block = (char *)malloc(128);
+#endif
+	assert(block && !(((size_t)block) % 64));
+
+#if defined __USE_MISC || defined _GNU_SOURCE
+	page = (char *)memalign(4096, 100);
+	array = (char *)reallocarray(NULL, 4, 32);
+	array = (char *)reallocarray(array, 8, 32);
+#else
+	page = (char *)malloc(100);
+	array = (char *)malloc(8 * 32);
+#endif
+	assert(page && array);
+
+#ifdef AT_ALLOC_TRACK
+	assert(AT_STATS_QUERY(&after) == 0);
+	assert((after.live_no == (before.live_no + 3)) &&
+	       (after.live_amount == (before.live_amount + 128 + 100 + 256)));
+#endif
+
+	free(block);
+	free(page);
+	free(array);
+
+#ifdef AT_ALLOC_TRACK
+	assert(AT_STATS_QUERY(&after) == 0);
+	assert((after.live_no == before.live_no) && (after.live_amount == before.live_amount));
+#endif
+}
+#endif
+
+#if defined __USE_XOPEN2K8 || __GLIBC_USE(LIB_EXT2) \
+ || defined _POSIX_C_SOURCE && _POSIX_C_SOURCE >= 200809L \
+ || defined _XOPEN_SOURCE && _XOPEN_SOURCE >= 700 \
+ || defined _GNU_SOURCE
+static void test_strndup(void)
+{
+	char *prefix = NULL, *line = NULL;
+#ifdef AT_ALLOC_TRACK
+	at_stats_t before, after;
+
+	assert(AT_STATS_QUERY(&before) == 0);
+#endif
+
+	prefix = strndup("abcdefghijklmnopqrstuvwxyz", 3);
+	assert(strlen(prefix) == 3);
+
+#if defined __STDC_VERSION__ && __STDC_VERSION__ >= 199901L \
+ && defined _GNU_SOURCE
+	assert(asprintf(&line, "%s:%d", prefix, 42) == 6);
+#else
+	line = strndup("abc:42", 6);
+#endif
+	assert(!strcmp(line, "abc:42"));
+
+#ifdef AT_ALLOC_TRACK
+	/* both are left unfreed for the report */
+	assert(AT_STATS_QUERY(&after) == 0);
+	assert((after.live_no == (before.live_no + 2)) &&
+	       (after.live_amount == (before.live_amount + 4 + 7)));
+#endif
+}
+#endif
+
+#if defined __USE_XOPEN2K \
+ || defined _POSIX_C_SOURCE && _POSIX_C_SOURCE >= 200112L
+static void test_descriptors(void)
+{
+	int fds[2] = { -1, -1 };
+	int sock = -1, file = -1, copy = -1;
+#ifdef AT_ALLOC_TRACK
+	at_stats_t before, after;
+
+	assert(AT_STATS_QUERY(&before) == 0);
+#endif
+
+	sock = socket(AF_UNIX, SOCK_STREAM, 0);
+	file = open("rsc/lines.txt", O_RDONLY);
+	copy = dup(file);
+
+	assert(sock >= 0);
+	assert(file >= 0);
+	assert(copy >= 0);
+	assert(pipe(fds) == 0);
+	assert(close(file) == 0);
+	assert(close(fds[0]) == 0);
+
+#ifdef AT_ALLOC_TRACK
+	/* the socket, the copy and one end of the pipe are left open */
+	assert(AT_STATS_QUERY(&after) == 0);
+	assert((after.fd_open_no == (before.fd_open_no + 5)) &&
+	       (after.fd_close_no == (before.fd_close_no + 2)) &&
+	       (after.fd_no == (before.fd_no + 3)));
+	assert(AT_FD_QUERY(sock) == AT_FD_TYPE_SOCKET);
+	assert(AT_FD_QUERY(copy) == AT_FD_TYPE_DUP);
+	assert(AT_FD_QUERY(fds[1]) == AT_FD_TYPE_PIPE);
+	assert((AT_FD_QUERY(file) == (-1)) && (AT_FD_QUERY(fds[0]) == (-1)));
+#endif
+}
+#endif
+
+#if defined __USE_XOPEN2K \
+ || defined _POSIX_C_SOURCE && _POSIX_C_SOURCE >= 200112L
+static void test_fork(void)
+{
+	char *block = NULL;
+	pid_t child;
+	int status = 0;
+#ifdef AT_ALLOC_TRACK
+	at_shm_segment_t *segment = NULL;
+	size_t i = 0, found = 0, parent = 0;
+	int fd = -1, line = 0;
+	char *large = NULL, name[AT_SHM_SITE_NAME];
+#endif
+
+	AT_SHM_PUBLISH("/alloctracker_test");
+	child = fork();
+	assert(child >= 0);
+
+	if(!child) /* tracks into a clean slot of its own */
+	{
+		block = (char *)malloc(64);
+		free(block);
+		_exit(0);
+	}
+
+	assert(waitpid(child, &status, 0) == child);
+	assert(WIFEXITED(status) && !WEXITSTATUS(status));
+
+#ifdef AT_ALLOC_TRACK
+	/* the slot of the child counts its own block only */
+	assert((fd = shm_open("/alloctracker_test", O_RDONLY, 0)) >= 0);
+	segment = (at_shm_segment_t *)mmap(NULL, sizeof(at_shm_segment_t), PROT_READ,
+	                                   MAP_SHARED, fd, 0);
+	assert(segment != MAP_FAILED);
+	assert(close(fd) == 0);
+	assert(segment->magic == AT_SHM_MAGIC);
+
+	for(i = 0; i < segment->slot_no; i++)
+	{
+		if(segment->slots[i].pid == (int)getpid()) ++parent;
+		if(segment->slots[i].pid != (int)child) continue;
+
+		++found;
+		assert((segment->slots[i].stats.alloc_no == 1) &&
+		       (segment->slots[i].stats.free_no == 1) &&
+		       (segment->slots[i].stats.alloc_amount == 64));
+	}
+
+	assert((found == 1) && (parent == 1));
+
+	/* a ranked site which frees its blocks gives up its rank */
+	for(i = 0; segment->slots[i].pid != (int)getpid(); i++);
+	line = (__LINE__ + 1);
+	large = (char *)malloc(8 << 20);
+	block = (char *)malloc(4 << 20);
+	assert(segment->slots[i].sites[0].live_amount == (8 << 20));
+	free(large);
+
+	snprintf(name, sizeof(name), "at_test.c:%d", (line + 1));
+	assert(!strcmp(segment->slots[i].sites[0].name, name));
+	assert(segment->slots[i].sites[0].live_amount == (4 << 20));
+	free(block);
+	assert(segment->slots[i].sites[0].live_amount != (4 << 20));
+
+	assert(munmap(segment, sizeof(at_shm_segment_t)) == 0);
+#endif
+
+	shm_unlink("/alloctracker_test");
+}
+#endif
+
+#ifdef AT_ALLOC_TRACK
+static void sampler_read(at_sample_ring_t *ring, at_sample_t *samples, size_t length)
+{
+	FILE *file = fopen("rsc/samples.ring", "rb");
+
+	assert(file);
+	assert(fread(ring, sizeof(at_sample_ring_t), 1, file) == 1);
+	if(length) assert(fread(samples, sizeof(at_sample_t), length, file) == length);
+	fclose(file);
+}
+#endif
+
+static void test_sampler(void)
+{
+	char *blocks[16];
+	int i;
+#ifdef AT_ALLOC_TRACK
+	at_sample_ring_t ring;
+	at_sample_t samples[64];
+	uint64_t written = 0, alloc_no = 0;
+#endif
+
+	AT_SAMPLER_START("rsc/samples.ring", 5, 64);
+
+	for(i = 0; i < 16; i++)
+	{
+		blocks[i] = (char *)malloc(256);
+		usleep(1000);
+	}
+
+#ifdef AT_ALLOC_TRACK
+	/* wait for a sample taken after the last allocation */
+	sampler_read(&ring, NULL, 0);
+	written = ring.written;
+
+	for(i = 0; (i < 5000) && (ring.written <= written); i++)
+	{
+		usleep(1000);
+		sampler_read(&ring, NULL, 0);
+	}
+#else
+	usleep(20000);
+#endif
+
+	AT_SAMPLER_STOP;
+
+#ifdef AT_ALLOC_TRACK
+	sampler_read(&ring, samples, 64);
+	assert((ring.magic == AT_SAMPLE_MAGIC) && (ring.sample_size == sizeof(at_sample_t)));
+	assert((ring.capacity == 64) && (ring.interval == 5) && (ring.written > written));
+	assert(samples[(written % 64)].live_amount >= (16 * 256));
+
+	/* the samples count the allocations since the previous one */
+	if(ring.written <= 64)
+	{
+		for(written = 0; written < ring.written; written++)
+			alloc_no += samples[written].alloc_no;
+
+		assert(alloc_no >= 16);
+	}
+#endif
+
+	for(i = 0; i < 16; i++) free(blocks[i]);
+}
+
+static void test_scopes(void)
+{
+	char *request = NULL, *parse = NULL;
+#ifdef AT_ALLOC_TRACK
+	at_scope_stats_t scope;
+#endif
+
+	AT_SCOPE_PUSH("request");
+	request = (char *)malloc(512);
+	AT_SCOPE_PUSH("request/parse");
+	parse = (char *)malloc(128);
+	free(parse);
+	AT_SCOPE_POP;
+	free(request);
+	AT_SCOPE_POP;
+
+#ifdef AT_ALLOC_TRACK
+	assert(AT_SCOPE_QUERY("request/parse", &scope) == 0);
+	assert((scope.alloc_no == 1) && (scope.peak_amount == 128) && !(scope.live_amount));
+#endif
+}
+
+#ifdef AT_ALLOC_TRACK
+static void budget_exceeded(const char *filename, const char *function,
+	int line, size_t live, size_t budget, int hard, void *data)
+{
+	(void)filename;
+	(void)function;
+	(void)line;
+	(void)live;
+	(void)budget;
+	++(((int *)data)[hard]);
+}
+
+static void test_budget(void)
+{
+	char *cache[8], text[6000], *buffer = NULL;
+	int exceeded[2] = { 0, 0 };
+	size_t blen = 0;
+	FILE *stream = NULL;
+	int i;
+
+	AT_BUDGET_CALLBACK(budget_exceeded, exceeded);
+	AT_BUDGET("test_budget", 1024, 4096);
+
+	for(i = 0; i < 8; i++) cache[i] = (char *)malloc(768); /* runaway cache */
+	for(i = 0; i < 8; i++) free(cache[i]);
+	assert((exceeded[0] == 1) && (exceeded[1] == 1));
+
+	/* a buffer grown by "getline" counts against the budget as well */
+	memset(text, 'x', (sizeof(text) - 1));
+	text[(sizeof(text) - 1)] = '\n';
+	assert((stream = fmemopen(text, sizeof(text), "r")));
+	blen = 16;
+	buffer = (char *)malloc(blen);
+	assert(getline(&buffer, &blen, stream) == (ssize_t)sizeof(text));
+	(fclose)(stream);
+	free(buffer);
+
+	AT_BUDGET_CALLBACK(NULL, NULL);
+	assert((exceeded[0] == 1) && (exceeded[1] == 2));
+}
+
+static void test_leak_scan(void)
+{
+	at_leak_suspect_t suspects[8];
+	char *sessions[40];
+	int i, found = -1, length, passes;
+
+	AT_LEAK_SCAN_START(60000); /* the passes are forced below */
+	passes = AT_LEAK_PASS;
+
+	for(i = 0; i < 40; i++)
+	{
+		sessions[i] = (char *)malloc(64); /* sessions are never expired */
+		if((i % 8) == 7) AT_LEAK_PASS;
+	}
+
+	assert(AT_LEAK_PASS == (passes + 6));
+	length = AT_LEAK_SUSPECTS(suspects, 8);
+	AT_LEAK_SCAN_STOP;
+
+	for(i = 0; i < length; i++)
+		if(!strcmp(suspects[i].function, "test_leak_scan")) found = i;
+
+	assert((found >= 0) && suspects[found].score && (suspects[found].live_no == 40) &&
+	       (suspects[found].old_no == 40) && (suspects[found].streak == 5));
+	for(i = 0; i < 40; i++) free(sessions[i]);
+}
+
+static void test_dump(void)
+{
+	struct sigaction action;
+
+	AT_DUMP_ON_SIGNAL(SIGUSR1);
+#ifdef AT_ALLOC_TRACK
+	assert((sigaction(SIGUSR1, NULL, &action) == 0) && (action.sa_handler != SIG_DFL));
+#endif
+
+	AT_DUMP_STOP; /* the default handler is back */
+	assert((sigaction(SIGUSR1, NULL, &action) == 0) && (action.sa_handler == SIG_DFL));
+}
+
+struct reach_node
+{
+	struct reach_node *next;
+	char payload[24];
+};
+
+static struct reach_node *reach_cache = NULL;
+static int reach_drop_line = 0;
+static int reach_hold_line = 0;
+
+static void reach_drop(void)
+{
+	char *lost = NULL;
+
+	reach_drop_line = (__LINE__ + 1);
+	lost = (char *)malloc(48);
+	memset(lost, 'x', 48);
+}
+
+static sem_t reach_held;
+static sem_t reach_release;
+
+static void *reach_hold(void *unused)
+{
+	char *volatile held = NULL;
+
+	(void)unused;
+	reach_hold_line = (__LINE__ + 1);
+	held = (char *)malloc(40); /* referenced from this stack only */
+	sem_post(&reach_held);
+	while(sem_wait(&reach_release) != 0);
+	free(held);
+	return NULL;
+}
+
+static void test_reach(void)
+{
+	struct reach_node *node = NULL;
+	struct sigaction action;
+	at_site_stats_t site;
+	pthread_t thread;
+	int i, line = 0;
+
+	assert((sem_init(&reach_held, 0, 0) == 0) && (sem_init(&reach_release, 0, 0) == 0));
+	assert(pthread_create(&thread, NULL, reach_hold, NULL) == 0);
+	while(sem_wait(&reach_held) != 0);
+
+	for(i = 0; i < 3; i++) /* reachable from a global */
+	{
+		line = (__LINE__ + 1);
+		node = (struct reach_node *)malloc(sizeof(struct reach_node));
+		node->next = reach_cache;
+		reach_cache = node;
+	}
+
+	reach_drop(); /* unreachable once it returns */
+
+	/* stale words may keep other blocks, leaked earlier, reachable */
+#ifdef AT_ALLOC_TRACK
+	assert(AT_REACH_SCAN >= 1);
+	assert((AT_SITE_QUERY(__FILE__, reach_drop_line, &site) == 0) && (site.reach_no == 1));
+	assert((AT_SITE_QUERY(__FILE__, reach_hold_line, &site) == 0) && !(site.reach_no));
+	assert((AT_SITE_QUERY(__FILE__, line, &site) == 0) && !(site.reach_no));
+#endif
+	sem_post(&reach_release);
+	assert(pthread_join(thread, NULL) == 0);
+
+	/* the handler of the signal stopping the threads is restored */
+	assert((sigaction(SIGPWR, NULL, &action) == 0) && (action.sa_handler == SIG_DFL));
+	sem_destroy(&reach_held);
+	sem_destroy(&reach_release);
+
+	while((node = reach_cache))
+	{
+		reach_cache = node->next;
+		free(node);
+	}
+}
+
+static void test_recommend(void)
+{
+	char *messages[128], text[4096];
+	FILE *file = NULL;
+	size_t length = 0;
+	int i;
+
+	/* a site allocating only 48 byte messages is worth a pool */
+	for(i = 0; i < 128; i++) messages[i] = (char *)malloc(48);
+	for(i = 0; i < 128; i++) free(messages[i]);
+
+	assert(AT_RECOMMEND("rsc/recommend.json") == 0);
+	assert((file = fopen("rsc/recommend.json", "r")));
+	length = fread(text, 1, (sizeof(text) - 1), file);
+	text[length] = '\0';
+	fclose(file);
+
+	assert(strstr(text, "\"size\": 48, \"slabs\": 128, \"hit_rate\": 1.000"));
+	assert(strstr(text, "\"size_classes\": [\n"));
+}
+
+static void test_compact(void)
+{
+	at_stats_t before, after;
+	int *values[6000];
+	char *name = NULL;
+	int i;
+
+	assert(AT_STATS_QUERY(&before) == 0);
+	AT_COMPACT(1);
+
+	/* enough blocks for the records to grow, and to be squeezed */
+	for(i = 0; i < 6000; i++)
+	{
+		values[i] = (int *)malloc(sizeof(int));
+		*(values[i]) = i;
+	}
+
+	for(i = 0; i < 6000; i += 2) free(values[i]);
+	for(i = 1; i < 6000; i += 4) values[i] = (int *)realloc(values[i], (64 * sizeof(int)));
+	name = strdup("compact");
+
+	assert(AT_STATS_QUERY(&after) == 0);
+	assert(after.compact_no == (before.compact_no + 3001));
+
+	AT_COMPACT(0); /* records are kept until their blocks are freed */
+
+	for(i = 1; i < 6000; i += 2)
+	{
+		assert(*(values[i]) == i);
+		free(values[i]);
+	}
+
+	assert(!strcmp(name, "compact")); /* reported unfreed, from its record */
+	assert(AT_STATS_QUERY(&after) == 0);
+	assert((after.compact_no == (before.compact_no + 1)) &&
+	       (after.squeeze_no > before.squeeze_no));
+}
+
+static void test_faults(void)
+{
+	at_site_stats_t site;
+	char *buffer = NULL, *record = NULL;
+	int mode = AT_FAULT_START(4, 10); /* 1 when probing with "mincore" */
+	int line = 0, compact = 0;
+
+	assert((mode == 0) || (mode == 1));
+
+	/* the 256 pages are first touched here, and reported for this site */
+	line = (__LINE__ + 1);
+	buffer = (char *)malloc(1 << 20);
+	memset(buffer, 'x', (1 << 20));
+
+	AT_COMPACT(1); /* a block tracked by a compact record is probed as well */
+	compact = (__LINE__ + 1);
+	record = (char *)malloc(1 << 20);
+	AT_COMPACT(0);
+	memset(record, 'x', (1 << 20));
+
+	AT_FAULT_STOP; /* attributes the faults left over */
+
+#ifdef AT_ALLOC_TRACK
+	assert(AT_SITE_QUERY(__FILE__, line, &site) == 0);
+	assert(mode ? (site.fault_touched >= 256) : ((site.fault_minor + site.fault_major) > 0));
+	assert(AT_SITE_QUERY(__FILE__, compact, &site) == 0);
+	assert(mode ? (site.fault_touched >= 256) : ((site.fault_minor + site.fault_major) > 0));
+#endif
+
+	free(record);
+	free(buffer);
+}
+
+static void test_unused(void)
+{
+	at_site_stats_t site;
+	char *table = NULL, *buffer = NULL;
+	int line = 0, other = 0;
+
+	line = (__LINE__ + 1);
+	table = (char *)calloc(256, 4096);
+	other = (__LINE__ + 1);
+	buffer = (char *)malloc(8192); /* its contents tell nothing */
+
+	AT_UNUSED(4096);
+
+	/* left to the report: 4 of its 256 pages, about 1.6%, are used */
+	memset(table, 'x', (4 * 4096));
+	memset(buffer, '\0', 8192);
+
+#ifdef AT_ALLOC_TRACK
+	assert(AT_UNUSED_SCAN >= 1);
+	assert((AT_SITE_QUERY(__FILE__, line, &site) == 0) && (site.unused_no == 1) &&
+	       (site.unused_reserved == (256 * 4096)) && (site.unused_used == (4 * 4096)));
+	assert((AT_SITE_QUERY(__FILE__, other, &site) == 0) && !(site.unused_no));
+#endif
+
+	free(buffer);
+}
+#endif
+
+static void test_arena(void)
+{
+	struct at_arena *arena = at_arena_create("request", 4096);
+	char *block = NULL;
+	int i, j;
+
+	assert(arena);
+
+	for(i = 0; i < 4; i++) /* one reset per request */
+	{
+		for(j = 0; j < 64; j++)
+		{
+			block = (char *)at_arena_alloc(arena, 100);
+			assert(block && !(((size_t)block) % 16));
+			memset(block, 'x', 100);
+		}
+
+		at_arena_reset(arena);
+	}
+
+	at_arena_destroy(arena);
+}
+
 static void test_fopen(void)
 {
 	FILE *exis = fopen("rsc/lines.txt", "r");
@@ -156,6 +944,35 @@ static void test_freopen(void)
 	assert(reop2);
 }
 
+static void test_stream_io(void)
+{
+	FILE *temp = tmpfile();
+	char buffer[64];
+	int i;
+#if defined AT_ALLOC_TRACK && defined AT_IO_TRACK
+	at_stream_stats_t stream;
+#endif
+
+	assert(temp);
+	assert(setvbuf(temp, NULL, _IONBF, 0) == 0);
+
+	for(i = 0; i < 100; i++) fputs("x", temp); /* tiny unbuffered writes */
+
+	fprintf(temp, "\nline %d\n", i);
+	rewind(temp);
+	assert(fgets(buffer, sizeof(buffer), temp));
+	assert(fread(buffer, 1, 8, temp) == 8);
+
+#if defined AT_ALLOC_TRACK && defined AT_IO_TRACK
+	/* 63 bytes of the first line, then 8 more */
+	assert(AT_STREAM_QUERY(temp, &stream) == 0);
+	assert((stream.write_no == 101) && (stream.write_amount == 110));
+	assert((stream.read_no == 2) && (stream.read_amount == 71));
+#endif
+
+	fclose(temp);
+}
+
 static void test_tmpfile(void)
 {
 	FILE *temp1 = tmpfile();
@@ -179,11 +996,28 @@ int main(void)
 	test_malloc();
 	test_calloc();
 	test_realloc();
+	test_realloc_growth();
+	test_meta();
+	test_threads();
+	test_sampler();
+	test_scopes();
+	test_arena();
+#ifdef AT_ALLOC_TRACK
+	test_budget();
+	test_leak_scan();
+	test_dump();
+	test_reach();
+	test_recommend();
+	test_compact();
+	test_faults();
+	test_unused();
+#endif
 
 #if defined _XOPEN_SOURCE && _XOPEN_SOURCE >= 500 \
  || defined _POSIX_C_SOURCE && _POSIX_C_SOURCE >= 200809L \
  || defined _BSC_SOURCE || defined _SVID_SOURCE
  test_strdup();
+ test_duplicates();
 #endif
 
 #if defined __USE_XOPEN2K8 || __GLIBC_USE(LIB_EXT2) \
@@ -192,11 +1026,21 @@ int main(void)
  || defined _GNU_SOURCE
 	test_getline((char)0); /* let "getline" allocate buffer */
 	test_getline((char)1); /* preallocate buffer for "getline" */
+	test_strndup();
+#endif
+
+#if defined __USE_XOPEN2K \
+ || defined _POSIX_C_SOURCE && _POSIX_C_SOURCE >= 200112L
+	test_mmap();
+	test_aligned();
+	test_descriptors();
+	test_fork();
 #endif
 
 	test_fopen();
 	test_freopen();
 	test_tmpfile();
+	test_stream_io();
 
 	return 0;
 }
@@ -0,0 +1,191 @@
+/**
+ * alloctracker - track dynamic memory allocations and open files
+ * Copyright (C) 2019-2020 Daniel Haase
+ * Distributed under the Boost Software License, Version 1.0.
+ * See accompanying file LICENSE or copy at
+ * https://www.boost.org/LICENSE_1_0.txt
+ *
+ * The project is inspired by code written by my colleague Jan Z.
+ *
+ * File:    at_test_new.cpp
+ * Author:  Daniel Haase
+ *
+ */
+
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include "alloctracker.h"
+
+struct node
+{
+	node *next;
+	int value;
+};
+
+struct alignas(64) line
+{
+	char bytes[64];
+};
+
+static void exit_handler(void)
+{
+	AT_REPORT;
+	AT_FREE_ALL;
+	printf("[ ok ] done\n\n");
+}
+
+static void test_new(void)
+{
+	at_stats_t before, after;
+	node *head = NULL, *leak = NULL;
+	int *values = NULL;
+
+	assert(AT_STATS_QUERY(&before) == 0);
+	head = new node();
+	values = new int[16];
+	leak = new node();
+
+	assert(AT_STATS_QUERY(&after) == 0);
+	assert((after.live_no == (before.live_no + 3)) &&
+	       (after.live_amount == (before.live_amount + (2 * sizeof(node)) + (16 * sizeof(int)))));
+
+	head->next = leak; /* "leak" is reported with its call site */
+	for(int i = 0; i < 16; i++) values[i] = i;
+
+	delete head;
+	delete[] values;
+
+	assert(AT_STATS_QUERY(&after) == 0);
+	assert((after.live_no == (before.live_no + 1)) && (after.free_no == (before.free_no + 2)));
+	assert(after.mismatch_no == before.mismatch_no);
+	assert((after.timed_alloc_no == (before.timed_alloc_no + 3)) &&
+	       (after.timed_free_no == (before.timed_free_no + 2)));
+}
+
+static void test_library(void)
+{
+	std::vector<std::string> names;
+
+	/* allocations inside the standard library are attributed to the
+	   function calling "operator new" */
+	for(int i = 0; i < 64; i++) names.push_back(std::string(32, 'x'));
+	assert(names.size() == 64);
+}
+
+static void test_aligned(void)
+{
+	at_stats_t before, after;
+	line *lines = NULL;
+
+	assert(AT_STATS_QUERY(&before) == 0);
+	lines = new line[4];
+	assert(!(reinterpret_cast<std::size_t>(lines) % 64));
+	delete[] lines;
+
+	assert(AT_STATS_QUERY(&after) == 0);
+	assert((after.live_no == before.live_no) && (after.free_no == (before.free_no + 1)));
+}
+
+static void test_mismatch(void)
+{
+	at_stats_t before, after;
+	char *block = static_cast<char *>(malloc(32));
+	node *item = new node();
+
+	assert(AT_STATS_QUERY(&before) == 0);
+	::operator delete(block); /* reported: malloc released with delete */
+	free(item); /* reported: new released with free */
+
+	assert(AT_STATS_QUERY(&after) == 0);
+	assert((after.mismatch_no == (before.mismatch_no + 2)) &&
+	       (after.live_no == (before.live_no - 2)));
+}
+
+static void test_sized(void)
+{
+#ifdef __cpp_sized_deallocation
+	at_stats_t before, after;
+	node *exact = new node();
+	node *wrong = new node();
+
+	assert(AT_STATS_QUERY(&before) == 0);
+	::operator delete(exact, sizeof(node));
+	::operator delete(wrong, 1); /* reported: sized delete of 1 byte */
+
+	assert(AT_STATS_QUERY(&after) == 0);
+	assert((after.mismatch_no == (before.mismatch_no + 1)) &&
+	       (after.live_no == (before.live_no - 2)));
+#endif
+}
+
+static void test_untracked(void)
+{
+	at_stats_t before, after;
+	void *volatile block = (malloc)(32); /* not seen by the tracker */
+
+	assert(AT_STATS_QUERY(&before) == 0);
+	::operator delete(block); /* reported, and released all the same */
+
+	assert(AT_STATS_QUERY(&after) == 0);
+	assert((after.untracked_no == (before.untracked_no + 1)) &&
+	       (after.live_no == before.live_no) && (after.free_no == before.free_no));
+}
+
+/* the node is left to the exit by the shutdown; its release afterwards
+   is no longer matched to the torn down item */
+static void test_shutdown(void)
+{
+	at_stats_t before, after;
+	node *n = new node;
+	int fds[2] = { -1, -1 };
+	char byte = '\0';
+	struct at_arena *arena = at_arena_create("shutdown", 0);
+
+	assert(arena && at_arena_alloc(arena, 64));
+
+	/* this file is built without AT_IO_TRACK, the pipe is tracked directly */
+	assert(at_pipe(fds, __FILE__, __func__, __LINE__) == 0);
+	assert(AT_FD_QUERY(fds[0]) == AT_FD_TYPE_PIPE);
+
+	assert(AT_STATS_QUERY(&before) == 0);
+	AT_SHUTDOWN(0);
+	delete n;
+
+	assert(AT_STATS_QUERY(&after) == 0);
+	assert(after.untracked_no == (before.untracked_no + 1));
+
+	/* the descriptors are left to the application */
+	assert((fcntl(fds[0], F_GETFD) != (-1)) && (fcntl(fds[1], F_GETFD) != (-1)));
+	assert(write(fds[1], "x", 1) == 1);
+	assert((read(fds[0], &byte, 1) == 1) && (byte == 'x'));
+	close(fds[0]);
+	close(fds[1]);
+
+	/* the arena still alive was released, its handle acts as destroyed */
+	assert(!at_arena_alloc(arena, 64));
+	at_arena_reset(arena);
+	at_arena_destroy(arena);
+}
+
+int main(void)
+{
+	atexit(exit_handler);
+
+	printf("\n[ ok ] alloctracker version %s\n", at_version());
+
+	test_new();
+	test_library();
+	test_aligned();
+	test_mismatch();
+	test_sized();
+	test_untracked();
+	test_shutdown(); /* last, it tears the tracker down */
+
+	return 0;
+}